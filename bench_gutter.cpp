@@ -0,0 +1,342 @@
+#include "gutter_apply.h"
+#include "gutter_fenwick.h"
+#include "gutter_retrieve.h"
+#include "gutter_retrieve_wide.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Usage: gutterBench [log2_max] [--json] [--queries=N]
+ *
+ * Measures the latency of the gutter classes' operations, over sizes 'n' from
+ * 2^10 to 2^log2_max (24 by default; up to 4 GB of nodes at 2^28), at both
+ * powers of 2 and just above 3/4 of them. Each call of an operation (of random
+ * arguments, drawn up front) is timed on its own, less the cost of reading the
+ * clock, and the operation is reported as the mean, median (p50) and 99th
+ * percentile (p99) latency per call, in nanoseconds, along with the throughput
+ * in calls per second. Calls shorter than the resolution of the clock read as
+ * 0 or as one tick, so the percentiles of the fastest operations are coarse.
+ *
+ * Results are printed as tab-separated tables, or with --json as a single JSON
+ * document, with one entry per (suite, tree, type, functor, operation, n).
+ */
+
+// Hides the commutativity of add<T>, forcing the generic accumulate walk
+template <typename T>
+struct add_unordered : add<T> {};
+
+template <typename T> struct bench_name;
+template <> struct bench_name<int> { static const char* value() { return "int"; } };
+template <> struct bench_name<long long> { static const char* value() { return "int64"; } };
+template <> struct bench_name<double> { static const char* value() { return "double"; } };
+template <typename T> struct bench_name<add<T> > { static const char* value() { return "add"; } };
+template <typename T> struct bench_name<add_unordered<T> > {
+	static const char* value() { return "add_unordered"; }
+};
+template <typename T> struct bench_name<mult<T> > { static const char* value() { return "mult"; } };
+template <typename T> struct bench_name<min<T> > { static const char* value() { return "min"; } };
+template <typename T> struct bench_name<max<T> > { static const char* value() { return "max"; } };
+
+// Element values, chosen so that no result overflows at 2^28 elements
+template <typename T, typename FUNCTOR_T>
+T bench_value(std::mt19937_64& rng, FUNCTOR_T) {
+	return T(rng()%4);
+}
+template <typename T>
+T bench_value(std::mt19937_64& rng, min<T>) {
+	return T(rng()%1000);
+}
+template <typename T>
+T bench_value(std::mt19937_64& rng, max<T>) {
+	return T(rng()%1000);
+}
+// - products of 1s and -1s neither overflow nor shrink to 0
+template <typename T>
+T bench_value(std::mt19937_64& rng, mult<T>) {
+	return (rng() & 1) ? T(1) : T(-1);
+}
+
+struct bench_result {
+	std::string suite, tree, type, functor, op;
+	std::size_t n;
+	double mean, p50, p99;	// latency per call (ns)
+};
+
+class bench_report {
+private:
+	const bool json;
+	std::vector<bench_result> results;
+	std::string suite;
+public:
+	explicit bench_report(bool as_json) : json(as_json) {}
+
+	void section(const char* name, const char* title) {
+		suite = name;
+		if (json)
+			return;
+		std::cout << "Benchmark:\t" << title << std::endl;
+		std::cout << "tree\ttype\tfunctor\top\tn\tmean\tp50\tp99\tops/s" << std::endl;
+	}
+	void add(bench_result result) {
+		result.suite = suite;
+		if (json) {
+			results.push_back(result);
+			return;
+		}
+		std::cout << result.tree << "\t" << result.type << "\t" << result.functor
+			<< "\t" << result.op << "\t" << result.n << "\t" << result.mean
+			<< "\t" << result.p50 << "\t" << result.p99 << "\t" << 1e9/result.mean
+			<< std::endl;
+	}
+	void finish(std::size_t log2_max, std::size_t queries) const {
+		if (!json)
+			return;
+		std::cout << "{\n\t\"context\": {\"log2_max\": " << log2_max
+			<< ", \"queries\": " << queries << ", \"time_unit\": \"ns\"},\n"
+			<< "\t\"benchmarks\": [";
+		for (std::size_t i=0; i<results.size(); ++i) {
+			const bench_result& r = results[i];
+			std::cout << (i ? ",\n" : "\n") << "\t\t{\"name\": \"" << r.suite << "/"
+				<< r.tree << "/" << r.type << "/" << r.functor << "/" << r.op << "/"
+				<< r.n << "\", \"suite\": \"" << r.suite << "\", \"tree\": \"" << r.tree
+				<< "\", \"type\": \"" << r.type << "\", \"functor\": \"" << r.functor
+				<< "\", \"op\": \"" << r.op << "\", \"n\": " << r.n
+				<< ", \"mean_ns\": " << r.mean << ", \"p50_ns\": " << r.p50
+				<< ", \"p99_ns\": " << r.p99 << ", \"ops_per_sec\": " << 1e9/r.mean << "}";
+		}
+		std::cout << "\n\t]\n}" << std::endl;
+	}
+};
+
+// = the median cost of reading the clock twice, in nanoseconds
+inline double bench_clock_overhead() {
+	typedef std::chrono::steady_clock clock;
+	std::vector<double> samples(1001);
+	for (std::size_t k=0; k<samples.size(); ++k) {
+		const clock::time_point start = clock::now();
+		samples[k] = std::chrono::duration<double,std::nano>(clock::now()-start).count();
+	}
+	std::nth_element(samples.begin(), samples.begin()+samples.size()/2, samples.end());
+	return samples[samples.size()/2];
+}
+
+// Times each of the 'count' calls call(0), ..., call(count-1) on its own, less
+// the cost of reading the clock
+template <typename CALL_T>
+bench_result bench_measure(CALL_T call, std::size_t count) {
+	typedef std::chrono::steady_clock clock;
+	static const double overhead = bench_clock_overhead();
+	std::vector<double> samples(count);
+	double total = 0;
+	for (std::size_t i=0; i<count; ++i) {
+		const clock::time_point start = clock::now();
+		call(i);
+		const double ns = std::chrono::duration<double,std::nano>(clock::now()-start).count();
+		samples[i] = std::max(0.0, ns-overhead);
+		total += samples[i];
+	}
+	std::sort(samples.begin(), samples.end());
+	bench_result result;
+	result.n = 0;
+	result.mean = total/count;
+	result.p50 = samples[count/2];
+	result.p99 = samples[std::min(count-1, count*99/100)];
+	return result;
+}
+
+template <typename RESULT_T, typename FUNCTOR_T, typename TREE_T>
+class bench_gutter {
+private:
+	typedef std::size_t INDEX_T;
+
+	TREE_T tree;
+	const INDEX_T size;
+	const INDEX_T queries;
+	std::vector<INDEX_T> bounds;	// random ranges [bounds[2i],bounds[2i+1])
+	std::vector<INDEX_T> starts;	// random ranges [starts[i],starts[i]+width)
+	std::vector<RESULT_T> values;
+	std::string name;
+	volatile RESULT_T sink;	// keeps the queries from being elided
+
+	bench_result labelled(bench_result result, const char* op) const {
+		result.tree = name;
+		result.type = bench_name<RESULT_T>::value();
+		result.functor = bench_name<FUNCTOR_T>::value();
+		result.op = op;
+		result.n = size;
+		return result;
+	}
+
+public:
+	// - range assigns and copies are timed over 1 in 'range_share' as many
+	//	 calls, as each one writes 'width' elements
+	enum { width = 256, range_share = 16 };
+
+	bench_gutter(const char* tree_name, INDEX_T length, INDEX_T count)
+	: tree(length), size(length), queries(count), bounds(2*count),
+	starts(count/range_share+1), values(length), name(tree_name), sink() {
+		std::mt19937_64 rng(length);
+		for (INDEX_T i=0; i<bounds.size(); i+=2) {
+			INDEX_T i1 = rng()%size, i2 = rng()%(size+1);
+			bounds[i] = std::min(i1,i2);
+			bounds[i+1] = std::max(i1,i2);
+		}
+		for (INDEX_T i=0; i<starts.size(); ++i)
+			starts[i] = rng()%(size-width+1);
+		for (INDEX_T i=0; i<size; ++i)
+			values[i] = bench_value<RESULT_T>(rng, FUNCTOR_T());
+	}
+	void rebuild() {
+		tree.rebuild(values.begin(), values.end());
+	}
+
+	// accumulate(I,I), over random ranges
+	bench_result accumulate() {
+		return labelled(bench_measure([this](INDEX_T i) {
+			sink = tree.accumulate(bounds[2*i], bounds[2*i+1]);
+		}, queries), "accumulate");
+	}
+	// apply(I,T), at random elements
+	bench_result apply() {
+		RESULT_T delta = 1;
+		return labelled(bench_measure([this,&delta](INDEX_T i) {
+			tree.apply(bounds[2*i], delta);
+		}, queries), "apply");
+	}
+	// assign(I,I,iter), over random ranges of 'width' elements
+	bench_result assign_range() {
+		return labelled(bench_measure([this](INDEX_T i) {
+			tree.assign(starts[i], starts[i]+width, values.begin());
+		}, starts.size()), "assign_range");
+	}
+	// apply(I,I,T), over random ranges
+	bench_result apply_range() {
+		RESULT_T delta = 1;
+		return labelled(bench_measure([this,&delta](INDEX_T i) {
+			tree.apply(bounds[2*i], bounds[2*i+1], delta);
+		}, queries), "apply_range");
+	}
+	// operator[](I), at random elements
+	bench_result get() {
+		return labelled(bench_measure([this](INDEX_T i) {
+			sink = tree[bounds[2*i]];
+		}, queries), "get");
+	}
+	// copy(I,I,iter), over random ranges of 'width' elements
+	bench_result copy() {
+		std::vector<RESULT_T> output(width);
+		return labelled(bench_measure([this,&output](INDEX_T i) {
+			tree.copy(starts[i], starts[i]+width, output.begin());
+		}, starts.size()), "copy");
+	}
+};
+
+struct bench_options {
+	std::size_t log2_max;
+	std::size_t queries;
+};
+
+// Sizes: 2^lg, and 3*2^(lg-2)+1, for lg = 10, 12, ..., log2_max
+inline std::vector<std::size_t> bench_sizes(const bench_options& options) {
+	std::vector<std::size_t> sizes;
+	for (std::size_t lg=10; lg<=options.log2_max; lg+=2) {
+		sizes.push_back(std::size_t(1) << lg);
+		sizes.push_back(3*(std::size_t(1) << (lg-2)) + 1);
+	}
+	return sizes;
+}
+
+// accumulate(I,I), apply(I,T), for classes with the gutter_retrieve interface
+template <typename RESULT_T, typename FUNCTOR_T, typename TREE_T>
+void bench_point(bench_report& report, const char* name, const bench_options& options) {
+	const std::vector<std::size_t> sizes = bench_sizes(options);
+	for (std::size_t s=0; s<sizes.size(); ++s) {
+		bench_gutter<RESULT_T,FUNCTOR_T,TREE_T> bench(name, sizes[s], options.queries);
+		bench.rebuild();
+		report.add(bench.accumulate());
+		report.add(bench.apply());
+	}
+}
+
+// All of the gutter_retrieve and gutter_apply operations, for one type/functor
+template <typename RESULT_T, typename FUNCTOR_T>
+void bench_matrix(bench_report& report, const bench_options& options) {
+	const std::vector<std::size_t> sizes = bench_sizes(options);
+	for (std::size_t s=0; s<sizes.size(); ++s) {
+		bench_gutter<RESULT_T,FUNCTOR_T,gutter_retrieve<RESULT_T,FUNCTOR_T> >
+			retrieve("retrieve", sizes[s], options.queries);
+		retrieve.rebuild();
+		report.add(retrieve.accumulate());
+		report.add(retrieve.apply());
+		report.add(retrieve.assign_range());
+	}
+	for (std::size_t s=0; s<sizes.size(); ++s) {
+		bench_gutter<RESULT_T,FUNCTOR_T,gutter_apply<RESULT_T,FUNCTOR_T> >
+			apply("apply", sizes[s], options.queries);
+		report.add(apply.apply_range());
+		report.add(apply.get());
+		report.add(apply.copy());
+	}
+}
+template <typename RESULT_T>
+void bench_matrix(bench_report& report, const bench_options& options) {
+	bench_matrix<RESULT_T,add<RESULT_T> >(report, options);
+	bench_matrix<RESULT_T,min<RESULT_T> >(report, options);
+	bench_matrix<RESULT_T,max<RESULT_T> >(report, options);
+	bench_matrix<RESULT_T,mult<RESULT_T> >(report, options);
+}
+
+int main(int argc, char** argv) {
+	bench_options options;
+	options.log2_max = 24;
+	options.queries = 1000000;
+	bool json = false;
+	for (int a=1; a<argc; ++a) {
+		if (std::strcmp(argv[a], "--json") == 0)
+			json = true;
+		else if (std::strncmp(argv[a], "--queries=", 10) == 0)
+			options.queries = std::strtoul(argv[a]+10, 0, 10);
+		else
+			options.log2_max = std::atoi(argv[a]);
+	}
+	if (options.log2_max < 10 || options.queries == 0) { //error?
+		std::cerr << "usage: " << argv[0] << " [log2_max>=10] [--json] [--queries=N>0]"
+			<< std::endl;
+		return 1;
+	}
+	bench_report report(json);
+
+	report.section("matrix", "gutter_retrieve, gutter_apply classes, by type and functor");
+	bench_matrix<int>(report, options);
+	bench_matrix<long long>(report, options);
+	bench_matrix<double>(report, options);
+
+	report.section("layout", "gutter_retrieve<int,+> class, by layout");
+	bench_point<int,add<int>,gutter_retrieve<int,add<int>,gutter_layout_bfs> >(
+			report, "bfs", options);
+	bench_point<int,add<int>,gutter_retrieve<int,add<int>,gutter_layout_blocked<4> > >(
+			report, "blocked<4>", options);
+
+	report.section("walk", "gutter_retrieve<int,+> class, generic vs. commutative walk");
+	bench_point<int,add_unordered<int>,gutter_retrieve<int,add_unordered<int> > >(
+			report, "generic", options);
+	bench_point<int,add<int>,gutter_retrieve<int,add<int> > >(
+			report, "commutative", options);
+
+	report.section("fanout", "gutter_retrieve_wide<int,+,F> class, by fanout");
+	bench_point<int,add<int>,gutter_retrieve_wide<int,add<int>,8> >(report, "wide<8>", options);
+	bench_point<int,add<int>,gutter_retrieve_wide<int,add<int>,16> >(report, "wide<16>", options);
+
+	report.section("fenwick", "gutter_fenwick<int,+> class vs. gutter_retrieve");
+	bench_point<int,add<int>,gutter_retrieve<int,add<int> > >(report, "retrieve", options);
+	bench_point<int,add<int>,gutter_fenwick<int,add<int> > >(report, "fenwick", options);
+
+	report.finish(options.log2_max, options.queries);
+	return 0;
+}
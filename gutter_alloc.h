@@ -0,0 +1,172 @@
+#ifndef GUTTER_ALLOC_H
+#define GUTTER_ALLOC_H
+/*
+ * These are allocators for the storage of the gutter classes. All of them meet
+ * the standard allocator requirements, and so can be passed as the 'ALLOC_T'
+ * parameter of the gutter classes (or of any standard container).
+ *
+ * The following allocators are provided:
+ *	- gutter_aligned_allocator<T,ALIGN>: aligns each allocation to 'ALIGN'
+ *		bytes (e.g., 64 to start the storage on a cache line for SIMD kernels)
+ *	- gutter_hugepage_allocator<T>: maps each allocation on its own 2MB-aligned
+ *		region and requests transparent huge pages for it (Linux only; falls
+ *		back to 2MB-aligned heap memory wherever madvise(MADV_HUGEPAGE) is
+ *		unavailable, or if GUTTER_NO_MADVISE is defined), cutting the TLB
+ *		misses of root-to-leaf walks on large trees
+ *	- gutter_arena_allocator<T>: carves allocations out of a caller-provided
+ *		gutter_arena buffer and never frees them individually, so that many
+ *		small trees share one contiguous block of memory
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#if defined(__linux__) && !defined(GUTTER_NO_MADVISE)
+#include <sys/mman.h>
+#endif
+#if !defined(MADV_HUGEPAGE) && !defined(GUTTER_NO_MADVISE)
+#define GUTTER_NO_MADVISE 1
+#endif
+
+template <typename T, std::size_t ALIGN=64>
+class gutter_aligned_allocator {
+	static_assert((ALIGN & (ALIGN-1)) == 0, "alignment must be a power of 2");
+public:
+	typedef T value_type;
+	template <typename U>
+	struct rebind {
+		typedef gutter_aligned_allocator<U,ALIGN> other;
+	};
+
+	gutter_aligned_allocator() {}
+	template <typename U>
+	gutter_aligned_allocator(const gutter_aligned_allocator<U,ALIGN>&) {}
+
+	T* allocate(std::size_t n) {
+		// Over-allocates, storing the original pointer just before the block
+		char* const raw = static_cast<char*>(
+				::operator new(n*sizeof(T) + ALIGN + sizeof(void*)));
+		const std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(raw)
+				+ sizeof(void*) + ALIGN-1) & ~std::uintptr_t(ALIGN-1);
+		reinterpret_cast<void**>(aligned)[-1] = raw;
+		return reinterpret_cast<T*>(aligned);
+	}
+	void deallocate(T* p, std::size_t) {
+		::operator delete(reinterpret_cast<void**>(p)[-1]);
+	}
+};
+template <typename T, typename U, std::size_t ALIGN>
+inline bool operator==(const gutter_aligned_allocator<T,ALIGN>&,
+		const gutter_aligned_allocator<U,ALIGN>&) {
+	return true;
+}
+template <typename T, typename U, std::size_t ALIGN>
+inline bool operator!=(const gutter_aligned_allocator<T,ALIGN>&,
+		const gutter_aligned_allocator<U,ALIGN>&) {
+	return false;
+}
+
+template <typename T>
+class gutter_hugepage_allocator {
+	static const std::size_t page = std::size_t(1) << 21;
+
+	static inline std::size_t rounded(std::size_t bytes) {
+		return (bytes + page-1) & ~(page-1);
+	}
+public:
+	typedef T value_type;
+
+	gutter_hugepage_allocator() {}
+	template <typename U>
+	gutter_hugepage_allocator(const gutter_hugepage_allocator<U>&) {}
+
+#if !defined(GUTTER_NO_MADVISE)
+	T* allocate(std::size_t n) {
+		const std::size_t bytes = rounded(n*sizeof(T));
+		// Maps an extra page, then trims the region to a 2MB boundary
+		void* const raw = mmap(0, bytes+page, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (raw == MAP_FAILED)
+			throw std::bad_alloc();
+		char* const first = static_cast<char*>(raw);
+		char* const aligned = reinterpret_cast<char*>(
+				(reinterpret_cast<std::uintptr_t>(first) + page-1) & ~std::uintptr_t(page-1));
+		if (aligned != first)
+			munmap(first, aligned-first);
+		if (aligned+bytes != first+bytes+page)
+			munmap(aligned+bytes, (first+bytes+page) - (aligned+bytes));
+		madvise(aligned, bytes, MADV_HUGEPAGE);
+		return reinterpret_cast<T*>(aligned);
+	}
+	void deallocate(T* p, std::size_t n) {
+		munmap(p, rounded(n*sizeof(T)));
+	}
+#else
+	T* allocate(std::size_t n) {
+		return gutter_aligned_allocator<T,page>().allocate(n);
+	}
+	void deallocate(T* p, std::size_t n) {
+		gutter_aligned_allocator<T,page>().deallocate(p, n);
+	}
+#endif
+};
+template <typename T, typename U>
+inline bool operator==(const gutter_hugepage_allocator<T>&,
+		const gutter_hugepage_allocator<U>&) {
+	return true;
+}
+template <typename T, typename U>
+inline bool operator!=(const gutter_hugepage_allocator<T>&,
+		const gutter_hugepage_allocator<U>&) {
+	return false;
+}
+
+// A caller-provided buffer, handed out front to back
+class gutter_arena {
+	char* next;
+	char* const end;
+public:
+	gutter_arena(void* buffer, std::size_t bytes)
+		: next(static_cast<char*>(buffer)), end(static_cast<char*>(buffer)+bytes) {}
+	void* allocate(std::size_t bytes, std::size_t align) {
+		char* const first = reinterpret_cast<char*>(
+				(reinterpret_cast<std::uintptr_t>(next) + align-1) & ~std::uintptr_t(align-1));
+		if (first > end || std::size_t(end-first) < bytes)
+			throw std::bad_alloc();
+		next = first+bytes;
+		return first;
+	}
+	std::size_t remaining() const {
+		return end-next;
+	}
+};
+
+template <typename T>
+class gutter_arena_allocator {
+	template <typename U> friend class gutter_arena_allocator;
+
+	gutter_arena* arena;
+public:
+	typedef T value_type;
+
+	gutter_arena_allocator(gutter_arena& source) : arena(&source) {}
+	template <typename U>
+	gutter_arena_allocator(const gutter_arena_allocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(std::size_t n) {
+		return static_cast<T*>(arena->allocate(n*sizeof(T), alignof(T)));
+	}
+	void deallocate(T*, std::size_t) {}	// memory is released with the arena
+
+	template <typename U>
+	bool operator==(const gutter_arena_allocator<U>& other) const {
+		return arena == other.arena;
+	}
+	template <typename U>
+	bool operator!=(const gutter_arena_allocator<U>& other) const {
+		return arena != other.arena;
+	}
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "gutter_base.h"
 #include <algorithm>
+#include <memory>
+#include <vector>
 
 /*
  * This class effectively stores an array of elements, but optimizes to
@@ -12,71 +14,164 @@
  * OPERATIONS & COMPLEXITY
  * 	- computing the 'i'th element
  * 		-> O(log(n))
+ *	- computing 'k' arbitrary elements at once
+ *		-> O(k*log(n)), with the walks of several elements interleaved
  *	- applying a value via the given operation to 'k' sequential elements
  *	  (e.g., setting a[i] = x + a[i] for i = 1, ..., k)
  *		-> O(log(n))
  *	- setting new values for 'k' sequential elements
  *		-> O(k+log(n)-log(k))
+ *	- pushing all pending values down to the leaves (e.g., before exporting
+ *	  the whole array)
+ *		-> O(n)
+ *
+ * Setting and copying elements first push the values pending at their
+ * ancestors down to the leaves ("consolidation"). Each internal node carries a
+ * pending bit, set when a value is applied to it and cleared when it is pushed
+ * down, so that consolidation skips the nodes left holding the identity
+ * element by an earlier consolidation (e.g., the top nodes, when range
+ * applies alternate with setting elements in the same region), rather than
+ * rewriting them and both of their children.
+ *
+ * The work done by each operation (walks, nodes visited, levels traversed, and
+ * optionally hardware counters) can be counted by passing an instrumentation
+ * policy as 'STATS_T' (see gutter_stats.h), and read back through stats(); the
+ * default policy counts nothing, at no cost.
  */
-template <typename RESULT_T, typename FUNCTOR_T>
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T=gutter_layout_bfs,
+		typename ALLOC_T=std::allocator<RESULT_T>, typename STATS_T=gutter_stats_none>
 class gutter_apply
-		: public gutter_base<RESULT_T, FUNCTOR_T> {
+		: public gutter_base<RESULT_T, FUNCTOR_T, LAYOUT_T, ALLOC_T, STATS_T> {
 
-	typedef gutter_base<RESULT_T, FUNCTOR_T> base;
+	typedef gutter_base<RESULT_T, FUNCTOR_T, LAYOUT_T, ALLOC_T, STATS_T> base;
 	typedef typename base::INDEX_T INDEX_T;
+	typedef std::vector<bool,
+			typename std::allocator_traits<ALLOC_T>::template rebind_alloc<bool> > pending_t;
 
-	inline void consolidate_to_children(INDEX_T index) {
-		this->heap[this->index_lbranch(index)]
-			= this->op(this->heap[this->index_lbranch(index)],this->heap[index]);
-		this->heap[this->index_rbranch(index)]
-			= this->op(this->heap[this->index_rbranch(index)],this->heap[index]);
-		this->heap[index] = this->op();
+	// Whether each internal node (by heap-style index, below 'n') may hold a
+	// value other than the identity element; left empty for adopted storage
+	// until first needed, as all of its nodes may be pending
+	pending_t pending;
+
+	inline void track_pending() {
+		if (pending.empty())
+			pending.assign(this->_size, true);
 	}
 	class functor_consolidate {
 	private:
 		RESULT_T* const binarray;
+		const LAYOUT_T layout;
 		FUNCTOR_T op;
+		pending_t& pending;
+		const INDEX_T internal;	// = the number of internal nodes, plus 1
 	public:
-		functor_consolidate(RESULT_T* array, FUNCTOR_T operation)
-			: binarray(array), op(operation) {}
-		void operator()(INDEX_T in) {
-			binarray[base::index_lbranch(index)]
-				= op(binarray[base::index_lbranch(index)],binarray[index]);
-			binarray[base::index_rbranch(index)]
-				= op(binarray[base::index_rbranch(index)],binarray[index]);
-			binarray[index] = op();
+		functor_consolidate(gutter_apply& tree)
+			: binarray(tree.heap), layout(tree.layout), op(tree.op),
+			pending(tree.pending), internal(tree._size) {}
+		void operator()(INDEX_T index) {
+			// Nodes without a pending value hold the identity element
+			if (!pending[index])
+				return;
+			pending[index] = false;
+			const INDEX_T l = base::index_lbranch(index), r = base::index_rbranch(index);
+			RESULT_T& parent = binarray[layout.position(index)];
+			RESULT_T& lbranch = binarray[layout.position(l)];
+			RESULT_T& rbranch = binarray[layout.position(r)];
+			gutter_combine<FUNCTOR_T>::into(op, lbranch, parent);
+			gutter_combine<FUNCTOR_T>::into(op, rbranch, parent);
+			parent = op();
+			if (l < internal)
+				pending[l] = true;
+			if (r < internal)
+				pending[r] = true;
 		}
 	};
+	inline void consolidate_to_children(INDEX_T index) {
+		functor_consolidate(*this)(index);
+	}
+	// Applies a pre-stored element to each node, marking it as pending
+	class functor_apply {
+	private:
+		typename base::functor_apply apply;
+		pending_t& pending;
+		const INDEX_T internal;
+	public:
+		functor_apply(gutter_apply& tree, const RESULT_T& in)
+			: apply(tree,in), pending(tree.pending), internal(tree._size) {}
+		void operator()(INDEX_T index) {
+			apply(index);
+			if (index < internal)
+				pending[index] = true;
+		}
+	};
+
+	gutter_apply(const gutter_apply& source, typename base::clone_tag tag)
+			: base(source,tag), pending(source.pending) {}
 
 public:
 	// Constructor
-	gutter_apply(INDEX_T n, FUNCTOR_T functor=FUNCTOR_T())
-			: base(n,functor) {
-		std::fill(this->heap+1,this->heap+(2*this->_size), this->op());
+	gutter_apply(INDEX_T n, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: base(n,functor,allocator), pending(n, false, allocator) {
+		std::fill(this->heap, this->heap+this->layout.storage_size(), this->op());
+	}
+	// - 'storage' must hold storage_size(n) nodes, and outlive the tree
+	gutter_apply(INDEX_T n, RESULT_T* storage, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: base(n,functor,storage,allocator), pending(n, false, allocator) {
+		std::fill(this->heap, this->heap+this->layout.storage_size(), this->op());
+	}
+	// - 'storage' already holds a built tree of 'n' elements (e.g., from a file)
+	gutter_apply(INDEX_T n, RESULT_T* storage, gutter_adopt_storage,
+			FUNCTOR_T functor=FUNCTOR_T(), const ALLOC_T& allocator=ALLOC_T())
+			: base(n,functor,storage,allocator), pending(allocator) {}
+	// Serves a tree written by save() straight out of the mapped file (runs in
+	// O(1) time, or O(n) time to verify the checksum; see gutter_file.h)
+	static gutter_mapped<gutter_apply> open_mmap(const char* path, bool verify=false) {
+		return gutter_mapped<gutter_apply>(path, verify);
+	}
+	// Deep copy (runs in O(n) time)
+	gutter_apply clone() const {
+		return gutter_apply(*this, typename base::clone_tag());
+	}
+	void swap(gutter_apply& other) {
+		base::swap(other);
+		pending.swap(other.pending);
 	}
 	// Access Method (run in O(1) time)
 	void apply(INDEX_T leaf_no, RESULT_T& x) {
-		this->heap[this->index_nth_leaf(leaf_no)]
-			= this->op(this->heap[this->index_nth_leaf(leaf_no)], x);
+		this->node(this->index_nth_leaf(leaf_no))
+			= this->op(this->node(this->index_nth_leaf(leaf_no)), x);
 	}
 	// Access Methods (run in O(log(n)) time)
 	void assign(INDEX_T leaf_no, RESULT_T& x) {
+		track_pending();
 		leaf_no = this->index_nth_leaf(leaf_no);
-		base::template act_on_all_ancestors_rootdown<auto>(
-			this->index_parent(leaf_no), functor_consolidate(this->heap, this->op));
+		base::template act_on_all_ancestors_rootdown(
+			this->index_parent(leaf_no), functor_consolidate(*this));
 		//for (INDEX_T i=1; i<this->_size; i*=2) {
 		//	consolidate_to_children(this->index_ancestor_in_row(leaf_no,i));
 		//}
-		this->heap[leaf_no] = this->op(this->heap[leaf_no], x);
+		this->node(leaf_no) = this->op(this->node(leaf_no), x);
 	}
 	RESULT_T operator[](INDEX_T leaf_no) const {
-		return base::template act_on_all_ancestors<auto>(
+		return base::template act_on_all_ancestors(
 			this->index_nth_leaf(leaf_no), typename base::functor_get(*this)
 		).result();
 	}
+	// Access Method (runs in O(k*log(n)) time)
+	// - computes out[j] = (*this)[leaves[j]], interleaving the walks of up to
+	//	 'lanes' elements at a time (see accumulate_batch of gutter_retrieve)
+	enum { batch_lanes = 8 };
+	void get_batch(const INDEX_T* leaves, std::size_t k, RESULT_T* out,
+			unsigned lanes=batch_lanes) const {
+		base::template act_interleaved<typename base::walk_all_ancestors>(
+				leaves, k, out, lanes);
+	}
 	void apply(INDEX_T i1, INDEX_T i2, RESULT_T& x) {
-		base::template act_on_min_covering_ancestors<auto>(
-			i1,i2, typename base::functor_apply(*this,x)
+		track_pending();
+		base::template act_on_min_covering_ancestors(
+			i1,i2, functor_apply(*this,x)
 		);
 	}
 	// Access Method (runs in O(k+log(n)-log(k)) time)
@@ -85,20 +180,32 @@ public:
 		if (i1>i2) //error?
 			return output;
 		else if (i1==i2) return output;
+		track_pending();
+		// The ancestors and the leaves are counted as one walk
+		const gutter_stats_scope<STATS_T> scope(this->instrument);
 		// Get Leaf positions
 		i1 = this->index_nth_leaf(i1);
 		i2 = this->index_nth_leaf(i2-1);	// make i2 an inclusive bound
 		// Consolidate all values in range to the bottom row
-		base::template act_on_all_ancestors_rootdown<auto>(
+		base::template act_on_all_ancestors_rootdown(
 			this->index_parent(i1),
 			this->index_parent(i2),
-			functor_consolidate(this->heap, this->op)
+			functor_consolidate(*this)
 		);
 		// Output results to iterator
-		return base::template act_on_leaves_in_order<auto>(
-			i1,i2, typename base::functor_get_to_iter<ITER_T>(*this,output)
+		return base::template act_on_leaves_in_order(
+			i1,i2, typename base::template functor_get_to_iter<ITER_T>(*this,output)
 		).iterator();
 	}
+	// Access Method (runs in O(n) time)
+	// - consolidates every internal node, parents before children, leaving
+	//	 each element in its leaf (e.g., for copy() to read off in O(k) time)
+	void flush() {
+		track_pending();
+		functor_consolidate consolidate(*this);
+		for (INDEX_T i=1; i<this->_size; ++i)
+			consolidate(i);
+	}
 };
 
 
@@ -0,0 +1,192 @@
+#ifndef GUTTER_APPLY_CONCURRENT_H
+#define GUTTER_APPLY_CONCURRENT_H
+
+#include "gutter_base.h"
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+/*
+ * This class provides the range-apply interface of gutter_apply to any number
+ * of concurrent threads, without locks.
+ *
+ * Applying a value to a range only combines it into the range's minimal
+ * covering ancestors, each independently; since the operation must be
+ * commutative (see gutter_is_commutative), those combines may happen in any
+ * order, and each is a single atomic read-modify-write on a
+ * std::atomic<RESULT_T> node (a fetch_add for integral sums, a compare-and-
+ * swap loop otherwise; see gutter_atomic_apply below).
+ *
+ * Every leaf has exactly one of a range's covering ancestors on its path to
+ * the root, so reading a point value never sees only part of an apply. To also
+ * order the reads between different applies, each node carries a version,
+ * incremented after each combine into the node; operator[] reads the versions
+ * and values of the O(log(n)) nodes on the leaf's path, then reads the
+ * versions again, and accepts the values only if no version changed (i.e., no
+ * apply landed on the path in between), retrying otherwise. Applies elsewhere
+ * in the tree never cause a retry, and there is no counter shared by all
+ * applies. A read is lock-free but not wait-free: it may retry for as long as
+ * applies keep landing on its path (e.g., near the root, under many writers of
+ * wide ranges). get_relaxed() skips this validation, never retries, and returns
+ * the value of the element for some subset of the concurrent applies.
+ *
+ * 'RESULT_T' must be trivially copyable (see std::atomic).
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the 'i'th element
+ * 		-> O(log(n)), plus one retry per apply landing on the leaf's path
+ *		   during the read
+ *	- applying a value via the given operation to 'k' sequential elements
+ *		-> O(log(n)) atomic operations
+ */
+
+// Atomically combines 'x' into a node, i.e., node = op(node, x)
+template <typename FUNCTOR_T, typename RESULT_T>
+inline void gutter_atomic_apply_cas(const FUNCTOR_T& op, std::atomic<RESULT_T>& node,
+		const RESULT_T& x) {
+	RESULT_T old = node.load(std::memory_order_relaxed);
+	while (!node.compare_exchange_weak(old, op(old, x),
+			std::memory_order_release, std::memory_order_relaxed)) {}
+}
+template <typename FUNCTOR_T>
+struct gutter_atomic_apply {
+	template <typename RESULT_T>
+	static inline void apply(const FUNCTOR_T& op, std::atomic<RESULT_T>& node,
+			const RESULT_T& x) {
+		gutter_atomic_apply_cas(op, node, x);
+	}
+};
+template <typename T>
+struct gutter_atomic_apply<add<T> > {
+	static inline void apply(const add<T>& op, std::atomic<T>& node, const T& x) {
+		apply(op, node, x, std::is_integral<T>());
+	}
+	static inline void apply(const add<T>&, std::atomic<T>& node, const T& x,
+			std::true_type) {
+		node.fetch_add(x, std::memory_order_release);
+	}
+	static inline void apply(const add<T>& op, std::atomic<T>& node, const T& x,
+			std::false_type) {
+		gutter_atomic_apply_cas(op, node, x);
+	}
+};
+// - for min/max, a value that would not change the node is never written
+template <typename T>
+struct gutter_atomic_apply<min<T> > {
+	static inline void apply(const min<T>&, std::atomic<T>& node, const T& x) {
+		T old = node.load(std::memory_order_relaxed);
+		while (x < old && !node.compare_exchange_weak(old, x,
+				std::memory_order_release, std::memory_order_relaxed)) {}
+	}
+};
+template <typename T>
+struct gutter_atomic_apply<max<T> > {
+	static inline void apply(const max<T>&, std::atomic<T>& node, const T& x) {
+		T old = node.load(std::memory_order_relaxed);
+		while (old < x && !node.compare_exchange_weak(old, x,
+				std::memory_order_release, std::memory_order_relaxed)) {}
+	}
+};
+
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T=gutter_layout_bfs>
+class gutter_apply_concurrent
+		: public gutter_base<std::atomic<RESULT_T>, FUNCTOR_T, LAYOUT_T> {
+	static_assert(std::is_trivially_copyable<RESULT_T>::value,
+			"gutter_apply_concurrent requires a trivially copyable RESULT_T");
+	static_assert(gutter_is_commutative<FUNCTOR_T>::value,
+			"gutter_apply_concurrent requires a commutative functor");
+
+	typedef gutter_base<std::atomic<RESULT_T>, FUNCTOR_T, LAYOUT_T> base;
+	typedef typename base::INDEX_T INDEX_T;
+
+	// The number of combines into each node so far, by storage position
+	std::unique_ptr<std::atomic<std::size_t>[]> versions;
+
+	inline std::atomic<std::size_t>& version(INDEX_T index) const {
+		return versions[this->layout.position(index)];
+	}
+
+	class functor_apply {
+	private:
+		gutter_apply_concurrent& tree;
+		const RESULT_T input;
+	public:
+		functor_apply(gutter_apply_concurrent& t, const RESULT_T& in)
+			: tree(t), input(in) {}
+		void operator()(INDEX_T index) const {
+			gutter_atomic_apply<FUNCTOR_T>::apply(tree.op, tree.node(index), input);
+			// Published after the combine, so that readers validating the node
+			// see either neither or both
+			tree.version(index).fetch_add(1, std::memory_order_release);
+		}
+	};
+	class functor_get {
+	private:
+		const gutter_apply_concurrent& tree;
+		RESULT_T res;
+	public:
+		functor_get(const gutter_apply_concurrent& t) : tree(t), res(t.op()) {}
+		void operator()(INDEX_T index) {
+			res = tree.op(res, tree.node(index).load(std::memory_order_relaxed));
+		}
+		const RESULT_T& result() {return res;}
+	};
+
+	inline RESULT_T get(INDEX_T leaf_no) const {
+		return base::template act_on_all_ancestors(
+			this->index_nth_leaf(leaf_no), functor_get(*this)
+		).result();
+	}
+
+public:
+	// Constructor
+	gutter_apply_concurrent(INDEX_T n, FUNCTOR_T functor=FUNCTOR_T())
+			: base(n,functor),
+			versions(new std::atomic<std::size_t>[this->layout.storage_size()]) {
+		for (INDEX_T i=0; i<this->layout.storage_size(); ++i) {
+			this->heap[i].store(this->op(), std::memory_order_relaxed);
+			versions[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// Access Methods (safe to call from any thread)
+	// - linearizable with respect to apply (runs in O(log(n)) time per attempt,
+	//	 retrying only while applies land on the leaf's path)
+	RESULT_T operator[](INDEX_T leaf_no) const {
+		std::size_t seen[8*sizeof(INDEX_T)];
+		while (true) {
+			RESULT_T res = this->op();
+			unsigned length = 0;
+			for (INDEX_T i=this->index_nth_leaf(leaf_no); i>0; i=this->index_parent(i)) {
+				seen[length++] = version(i).load(std::memory_order_acquire);
+				res = this->op(res, this->node(i).load(std::memory_order_relaxed));
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			// No combine into the path was published during the walk
+			bool unchanged = true;
+			length = 0;
+			for (INDEX_T i=this->index_nth_leaf(leaf_no); i>0 && unchanged;
+					i=this->index_parent(i))
+				unchanged = (version(i).load(std::memory_order_relaxed) == seen[length++]);
+			if (unchanged)
+				return res;
+		}
+	}
+	// - never retries (runs in O(log(n)) time)
+	RESULT_T get_relaxed(INDEX_T leaf_no) const {
+		const RESULT_T res = get(leaf_no);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return res;
+	}
+	// - runs in O(log(n)) time
+	void apply(INDEX_T i1, INDEX_T i2, const RESULT_T& x) {
+		if (i1>=i2) //error?
+			return;
+		base::template act_on_min_covering_ancestors(
+			i1,i2, functor_apply(*this,x)
+		);
+	}
+};
+
+
+#endif
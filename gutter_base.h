@@ -7,75 +7,217 @@
  *	other redundant information.
  *
  * This base class provides the following members/methods:
- *	- an internal heap-style array
- *	- a constructor allocating the array to a size 2'n', where 'n' is the number
- *		of gutter elements
- *	- methods for traversing the binary tree structure of the array
+ *	- an internal heap-style array, whose nodes are placed in storage by a
+ *		layout policy (see gutter_layout.h)
+ *	- a constructor allocating the array to hold 2'n'-1 nodes, where 'n' is the
+ *		number of gutter elements, through a standard-compatible allocator (see
+ *		gutter_alloc.h); alternatively, a constructor placing the array over
+ *		caller-provided storage of storage_size('n') nodes
+ *	- methods for traversing the binary tree structure of the array (see
+ *	  gutter_index.h)
  *		- parent index
  *		- left/right child index
- *		- 'k'th leaf index
+ *		- 'k'th leaf index, and the inverse
+ *		- number of leaves descending from a node
  *	- methods for performing functor operations on specific collections of nodes
  *		- all ancestors of a given leaf (performed root-down/leaf-up)
- *		- all ancestors of a collection of sequential leaves (root-down/leaf-up)
+ *		- all ancestors of a collection of sequential leaves (root-down/leaf-up,
+ *		  or leaf-up one row at a time)
+ *		- all ancestors of an arbitrary collection of nodes, each acted on once
+ *		  (leaf-up)
  *		- a sequence of leaves
  *		- the set of "minimal covering ancestors" of a sequence of leaves
  *		  (i.e., the minimum collection of nodes such that
  *			- each node is an ancestor of at least one leaf
  *			- each leaf has at least one node that is an ancestor)
- *	- functors to use with above node-collection operation methods
+ *	- functors to use with above node-collection operation methods, combining
+ *	  results in place through FUNCTOR_T::combine_into where the functor
+ *	  defines it (see gutter_combine), so that results holding heap storage
+ *	  are not copied on every node
+ *	- resumable forms of the "minimal covering ancestors" and "all ancestors of
+ *	  a leaf" walks, advancing one generation per step, and a method running
+ *	  several of them interleaved (so that their cache misses overlap)
+ *	- opt-in instrumentation of the node-collection operation methods, through
+ *	  an instrumentation policy (see gutter_stats.h)
+ *	- saving to a file, in a format that can be mapped back into memory and
+ *	  queried in place (see gutter_file.h)
+ *	- move construction/assignment and swapping in O(1) time, as well as deep
+ *	  copying through an explicit cloning constructor (copy construction is
+ *	  disabled, so that trees are never duplicated by accident)
  */
 
 #include <cstddef>
+#include <cstring>
 #include <algorithm>
-#include "BitTwiddles.h"
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "gutter_file.h"
+#include "gutter_index.h"
+#include "gutter_layout.h"
+#include "gutter_stats.h"
 
-template <typename RESULT_T, typename FUNCTOR_T>
-class gutter_base {
+#if defined(__GNUC__)
+#define GUTTER_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define GUTTER_PREFETCH(addr)
+#endif
+
+// Combines results in place, through FUNCTOR_T::combine_into where defined
+// (see below)
+template <typename FUNCTOR_T>
+struct gutter_combine;
+
+// Constrains the iterator-pair constructors of the gutter classes to iterator
+// types, so that they never take over a call with a pair of integers (e.g.,
+// a size and a value)
+template <typename ITER_T>
+using gutter_iterator_category = typename std::iterator_traits<ITER_T>::iterator_category;
+
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T=gutter_layout_bfs,
+		typename ALLOC_T=std::allocator<RESULT_T>, typename STATS_T=gutter_stats_none>
+class gutter_base : protected gutter_index {
 protected:
 	typedef std::size_t INDEX_T;
+	typedef std::allocator_traits<ALLOC_T> alloc_traits;
 
-	RESULT_T* const heap;
-	const INDEX_T _size;
+	INDEX_T _size;
+	LAYOUT_T layout;
+	ALLOC_T alloc;
+	bool owns_heap;	// false for caller-provided (or moved-from) storage
+	mutable STATS_T instrument;	// counts the work of the const methods too
+	RESULT_T* heap;
 	FUNCTOR_T op;
 
-	static inline INDEX_T index_parent(INDEX_T n) {
-		return n/2;
+	// Selects the cloning constructor
+	struct clone_tag {};
+
+	RESULT_T* allocate_heap() {
+		RESULT_T* const storage = alloc_traits::allocate(alloc, layout.storage_size());
+		if (!std::is_trivial<RESULT_T>::value) {
+			for (INDEX_T i=0; i<layout.storage_size(); ++i)
+				alloc_traits::construct(alloc, storage+i);
+		}
+		return storage;
 	}
-	static inline INDEX_T index_lbranch(INDEX_T n) {
-		return 2*n;
+	void deallocate_heap() {
+		if (!std::is_trivial<RESULT_T>::value) {
+			for (INDEX_T i=0; i<layout.storage_size(); ++i)
+				alloc_traits::destroy(alloc, heap+i);
+		}
+		alloc_traits::deallocate(alloc, heap, layout.storage_size());
 	}
-	static inline INDEX_T index_rbranch(INDEX_T n) {
-		return 2*n+1;
+	void copy_heap(const RESULT_T* source, std::true_type) {
+		std::memcpy(heap, source, layout.storage_size()*sizeof(RESULT_T));
 	}
-	static inline bool index_islbranch(INDEX_T index) {
-		return !(index%2);
+	void copy_heap(const RESULT_T* source, std::false_type) {
+		std::copy(source, source+layout.storage_size(), heap);
 	}
-	static inline INDEX_T index_first_of_row(INDEX_T index) {
-		// = the greatest power of 2 less than index
-		return msb(index);
+
+	// Deep-copies the source into newly allocated storage, in O(n) time
+	gutter_base(const gutter_base& source, clone_tag)
+		: _size(source._size), layout(source.layout),
+		alloc(alloc_traits::select_on_container_copy_construction(source.alloc)),
+		owns_heap(true), heap(allocate_heap()), op(source.op) {
+		copy_heap(source.heap, std::is_trivially_copyable<RESULT_T>());
 	}
-	inline INDEX_T index_nth_leaf(INDEX_T n) const {
-		const INDEX_T index_deepest_lvl_1st = index_first_of_row(2*_size-1);
-		return n + index_deepest_lvl_1st
-				- ((n+index_deepest_lvl_1st < 2*_size) ? 0 : _size);
+	void swap(gutter_base& other) {
+		std::swap(_size, other._size);
+		std::swap(layout, other.layout);
+		std::swap(alloc, other.alloc);
+		std::swap(owns_heap, other.owns_heap);
+		std::swap(instrument, other.instrument);
+		std::swap(heap, other.heap);
+		std::swap(op, other.op);
 	}
 
-	static inline INDEX_T index_ancestor_in_row(INDEX_T index, INDEX_T row_1st) {
-		while (index_parent(index) >= row_1st)
-			index = index_parent(index);
-		return index;
+	// Node storage, addressed by heap-style index
+	inline RESULT_T& node(INDEX_T index) {
+		return heap[layout.position(index)];
+	}
+	inline const RESULT_T& node(INDEX_T index) const {
+		return heap[layout.position(index)];
+	}
+
+	// Index helpers taking the size of the tree (see gutter_index.h, for the
+	// others)
+	inline INDEX_T index_nth_leaf(INDEX_T n) const {
+		return gutter_index::index_nth_leaf(n, _size);
+	}
+	inline INDEX_T index_leaf_no(INDEX_T index) const {
+		return gutter_index::index_leaf_no(index, _size);
+	}
+	inline INDEX_T index_leaf_count(INDEX_T index) const {
+		return gutter_index::index_leaf_count(index, _size);
 	}
 
 
 public:
-	gutter_base(INDEX_T n, FUNCTOR_T functor)
-		: op(functor), _size(n), heap((new RESULT_T[2*n-1])-1) {}
+	typedef RESULT_T result_type;
+	typedef FUNCTOR_T functor_type;
+	typedef LAYOUT_T layout_type;
+	typedef STATS_T stats_type;
+
+	gutter_base(INDEX_T n, FUNCTOR_T functor, const ALLOC_T& allocator=ALLOC_T())
+		: _size(n), layout(n), alloc(allocator), owns_heap(true),
+		heap(allocate_heap()), op(functor) {}
+	// - 'storage' must hold storage_size(n) constructed nodes, and outlive the
+	//	 tree; 'allocator' is only kept for the allocations of derived classes
+	gutter_base(INDEX_T n, FUNCTOR_T functor, RESULT_T* storage,
+			const ALLOC_T& allocator=ALLOC_T())
+		: _size(n), layout(n), alloc(allocator), owns_heap(false), heap(storage),
+		op(functor) {}
+	// - the source is left without storage, and may only be destroyed or
+	//	 assigned to
+	gutter_base(gutter_base&& source)
+		: _size(source._size), layout(source.layout), alloc(std::move(source.alloc)),
+		owns_heap(source.owns_heap), instrument(std::move(source.instrument)),
+		heap(source.heap), op(std::move(source.op)) {
+		source.owns_heap = false;
+		source.heap = 0;
+	}
+	gutter_base& operator=(gutter_base&& source) {
+		// The previous storage is released along with the source
+		swap(source);
+		return *this;
+	}
+	gutter_base(const gutter_base&) = delete;
+	gutter_base& operator=(const gutter_base&) = delete;
 	~gutter_base() {
-		delete[] (heap+1);
+		if (owns_heap)
+			deallocate_heap();
 	}
 	INDEX_T size() const {
 		return _size;
 	}
+	// = the number of nodes of storage needed by a tree of 'n' elements
+	static INDEX_T storage_size(INDEX_T n) {
+		return LAYOUT_T(n).storage_size();
+	}
+	// = the storage of the nodes, storage_size(n) of them, each placed at the
+	//	 position given by the layout (e.g., for copying the tree elsewhere)
+	const RESULT_T* data() const {
+		return heap;
+	}
+	// = the counts of the instrumentation policy (all zero for gutter_stats_none)
+	gutter_stats stats() const {
+		return instrument.stats();
+	}
+	void reset_stats() {
+		instrument.reset();
+	}
+	// Writes the tree to a file (see gutter_file.h); returns false on failure
+	bool save(const char* path) const {
+		static_assert(std::is_trivially_copyable<RESULT_T>::value,
+				"only trees of trivially copyable elements can be saved");
+		return gutter_file_save(path,
+				gutter_file_header::describe<RESULT_T,FUNCTOR_T,LAYOUT_T>(
+					_size, layout.storage_size()),
+				heap);
+	}
 	/*
 	void print() const {
 		INDEX_T i=0;
@@ -96,17 +238,23 @@ protected:
 
 	template<typename F>
 	inline F act_on_all_ancestors_leafup(INDEX_T index, F functor) const {
+		const gutter_stats_scope<STATS_T> scope(instrument);
+		gutter_stats_counted<F,STATS_T> counted(functor, instrument);
 		//index = index_nth_leaf(index);
 		while (index > 0) {
-			functor(index);
+			instrument.level();
+			counted(index);
 			index = index_parent(index);
 		}
 		return functor;
 	}
 	template<typename F>
 	inline F act_on_all_ancestors_rootdown(INDEX_T index, F functor) const {
-		for (INDEX_T i=1; i<index; i*=2) {
-			functor(index_ancestor_in_row(index,i));
+		const gutter_stats_scope<STATS_T> scope(instrument);
+		gutter_stats_counted<F,STATS_T> counted(functor, instrument);
+		for (INDEX_T i=1; i<=index; i*=2) {
+			instrument.level();
+			counted(index_ancestor_in_row(index,i));
 		}
 		return functor;
 	}
@@ -118,34 +266,59 @@ protected:
 	// TODO test!
 	template<typename F>
 	inline F act_on_all_ancestors_leafup(INDEX_T i1, INDEX_T i2, F functor) const {
+		const gutter_stats_scope<STATS_T> scope(instrument);
+		gutter_stats_counted<F,STATS_T> counted(functor, instrument);
 		if (i1>i2) {
+			instrument.level();
 			for (
 					INDEX_T j=i1;
 					j<=index_ancestor_in_row(2*_size-1,index_first_of_row(i1));
 					++j
 				) {
-				functor(j);
+				counted(j);
 			}
 			i1 = index_parent(i1);
 		}
 		while (i1 > 0) {
+			instrument.level();
 			for (INDEX_T j=i1; j<=i2; ++j) {
-				functor(j);
+				counted(j);
 			}
 			i1 = index_parent(i1);
 			i2 = index_parent(i2);
 		}
 		return functor;
 	}
+	// Same as above, but acts on each row's run of ancestors [j1,j2] at once
+	template<typename F>
+	inline F act_on_all_ancestors_leafup_rows(INDEX_T i1, INDEX_T i2, F functor) const {
+		const gutter_stats_scope<STATS_T> scope(instrument);
+		gutter_stats_counted<F,STATS_T> counted(functor, instrument);
+		if (i1>i2) {
+			instrument.level();
+			counted(i1, index_ancestor_in_row(2*_size-1,index_first_of_row(i1)));
+			i1 = index_parent(i1);
+		}
+		while (i1 > 0) {
+			instrument.level();
+			counted(i1, i2);
+			i1 = index_parent(i1);
+			i2 = index_parent(i2);
+		}
+		return functor;
+	}
 	template<typename F>
 	inline F act_on_all_ancestors_rootdown(INDEX_T i1, INDEX_T i2, F functor) const {
+		const gutter_stats_scope<STATS_T> scope(instrument);
+		gutter_stats_counted<F,STATS_T> counted(functor, instrument);
 		for (INDEX_T i=1; i<=i1; i*=2) {
+			instrument.level();
 			for (
 					INDEX_T j = index_ancestor_in_row(i1,i);
 					j <= index_ancestor_in_row((i<=i2 ?i2 :2*_size-1), i);
 					++j
 				) {
-				functor(j);
+				counted(j);
 			}
 		}
 		return functor;
@@ -155,19 +328,47 @@ protected:
 		return act_on_all_ancestors_leafup(i1,i2,functor);
 	}
 
+	// Acts on each of the given nodes and their ancestors exactly once, always
+	// after all of their descendants (the contents of 'frontier' are consumed)
+	template<typename F>
+	inline F act_on_shared_ancestors_leafup(std::vector<INDEX_T>& frontier, F functor) const {
+		const gutter_stats_scope<STATS_T> scope(instrument);
+		gutter_stats_counted<F,STATS_T> counted(functor, instrument);
+		const std::greater<INDEX_T> desc;
+		std::sort(frontier.begin(), frontier.end(), desc);
+		frontier.erase(std::unique(frontier.begin(), frontier.end()), frontier.end());
+		while (!frontier.empty() && frontier.front() > 0) {
+			// Act on the deepest row in the frontier, replacing nodes by parents
+			const INDEX_T row_1st = index_first_of_row(frontier.front());
+			typename std::vector<INDEX_T>::iterator row_end = frontier.begin();
+			instrument.level();
+			for (; row_end != frontier.end() && *row_end >= row_1st; ++row_end) {
+				counted(*row_end);
+				*row_end = index_parent(*row_end);
+			}
+			// Parents stay in descending order; merge them with the other rows
+			std::inplace_merge(frontier.begin(), row_end, frontier.end(), desc);
+			frontier.erase(std::unique(frontier.begin(), frontier.end()), frontier.end());
+		}
+		return functor;
+	}
+
 	template<typename F>
 	inline F act_on_min_covering_ancestors(INDEX_T i1, INDEX_T i2, F functor) const {
 		//std::cout << "gutter_base::act_on_min_covering_ancestors("
 		//		<<i1<<","<<i2<<") - begin..." << std::endl;
 		if (i1>=i2) return functor;
+		const gutter_stats_scope<STATS_T> scope(instrument);
+		gutter_stats_counted<F,STATS_T> counted(functor, instrument);
 		i1 = index_nth_leaf(i1);
 		i2 = index_nth_leaf(i2-1);	// sets index2 as an inclusive bound
 		while (true) {
+			instrument.level();
 			// Shift left bound up one generation
 			//std::cout << "("<<i1<<","<<i2<<")" << std::endl;
 			if (i1==i2) break;
 			if (!index_islbranch(i1)) {
-				functor(i1++);
+				counted(i1++);
 			//	std::cout << "("<<i1<<","<<i2<<")" << std::endl;
 				if (i1==i2) break;
 			}
@@ -176,27 +377,32 @@ protected:
 			//std::cout << "("<<i1<<","<<i2<<")" << std::endl;
 			if (i1==i2) break;
 			if (index_islbranch(i2)) {
-				functor(i2--);
+				counted(i2--);
 			//	std::cout << "("<<i1<<","<<i2<<")" << std::endl;
 				if (i1==i2) break;
 			}
 			i2 = index_parent(i2);
 		}
 		// Left and right bounds have reached a common ancestor
-		functor(i1);
+		counted(i1);
 		//std::cout << "gutter_base::act_on_min_covering_ancestors - done!" << std::endl;
 		return functor;
 	}
 
 	template<typename F>
 	inline F act_on_leaves_in_order(INDEX_T i1, INDEX_T i2, F functor) const {
+		const gutter_stats_scope<STATS_T> scope(instrument);
+		gutter_stats_counted<F,STATS_T> counted(functor, instrument);
 		INDEX_T i = i1;
 		++i2;	// make i2 an exclusive bound
 		// (Assume there is at least one leaf in range
+		instrument.level();
 		do {
-			if (i == 2*_size)
+			if (i == 2*_size) {
+				instrument.level();	// wraps around to the row above
 				i = index_parent(i);
-			functor(i++);
+			}
+			counted(i++);
 		} while (i != i2);
 		return functor;
 	}
@@ -206,29 +412,169 @@ protected:
 	private:
 		FUNCTOR_T op;
 		const RESULT_T* const binarray;
+		const LAYOUT_T layout;
 		RESULT_T res;
 	public:
 		functor_get(const gutter_base& ro_ba)
-				: op(ro_ba.op), binarray(ro_ba.heap), res(ro_ba.op()) {}
+				: op(ro_ba.op), binarray(ro_ba.heap), layout(ro_ba.layout),
+				res(ro_ba.op()) {}
 		void operator()(INDEX_T in) {
-			res = op(res, binarray[in]);
+			gutter_combine<FUNCTOR_T>::into(op, res, binarray[layout.position(in)]);
 		}
-		const RESULT_T& result() {return res;}
+		const RESULT_T& result() const & {return res;}
+		RESULT_T result() && {return std::move(res);}
 	};
 	// Assigns to each value, the functor operation between said value and a pre-stored element
 	class functor_apply {
 	private:
 		FUNCTOR_T op;
 		RESULT_T* const binarray;
-		const RESULT_T input;
+		const LAYOUT_T layout;
+		const RESULT_T& input;	// outlives the functor, as the caller's argument
 	public:
 		functor_apply(gutter_base& ro_ba, const RESULT_T &in)
-				: op(ro_ba.op), binarray(ro_ba.heap), input(in) {}
+				: op(ro_ba.op), binarray(ro_ba.heap), layout(ro_ba.layout), input(in) {}
 		void operator()(INDEX_T out) const {
-			binarray[out] = op(binarray[out], input);
+			gutter_combine<FUNCTOR_T>::into(op, binarray[layout.position(out)], input);
+		}
+	};
+
+	// Computes the same result as act_on_min_covering_ancestors with functor_get,
+	// advancing one generation per call to step() and prefetching the nodes of
+	// the next generation (left/right bound results are kept in leaf order)
+	class walk_min_covering_ancestors {
+	private:
+		FUNCTOR_T op;
+		const gutter_base* tree;
+		INDEX_T i1, i2;
+		RESULT_T lres, rres;
+		bool done;
+	public:
+		walk_min_covering_ancestors(const gutter_base& ro_ba)
+				: op(ro_ba.op), tree(&ro_ba), i1(0), i2(0),
+				lres(ro_ba.op()), rres(ro_ba.op()), done(true) {}
+		void start(INDEX_T leaf1, INDEX_T leaf2) {
+			lres = rres = op();
+			done = (leaf1 >= leaf2);
+			if (done) return;
+			tree->instrument.walk_begin();
+			i1 = tree->index_nth_leaf(leaf1);
+			i2 = tree->index_nth_leaf(leaf2-1);	// sets i2 as an inclusive bound
+			GUTTER_PREFETCH(&tree->node(i1));
+			GUTTER_PREFETCH(&tree->node(i2));
+		}
+		void start(const std::pair<INDEX_T,INDEX_T>& range) {
+			start(range.first, range.second);
+		}
+		// Returns true once the walk has finished
+		bool step() {
+			if (done) return true;
+			tree->instrument.level();
+			if (i1 != i2 && !index_islbranch(i1)) {
+				tree->instrument.visit(1);
+				gutter_combine<FUNCTOR_T>::into(op, lres, tree->node(i1++));
+			}
+			if (i1 != i2) {
+				i1 = index_parent(i1);
+				if (i1 != i2 && index_islbranch(i2)) {
+					tree->instrument.visit(1);
+					gutter_combine<FUNCTOR_T>::into_front(op, tree->node(i2--), rres);
+				}
+				if (i1 != i2) {
+					i2 = index_parent(i2);
+					GUTTER_PREFETCH(&tree->node(i1));
+					GUTTER_PREFETCH(&tree->node(i2));
+					return false;
+				}
+			}
+			// Left and right bounds have reached a common ancestor
+			tree->instrument.visit(1);
+			gutter_combine<FUNCTOR_T>::into(op, lres, tree->node(i1));
+			gutter_combine<FUNCTOR_T>::into(op, lres, rres);
+			tree->instrument.walk_end();
+			done = true;
+			return true;
+		}
+		const RESULT_T& result() const & {return lres;}
+		RESULT_T result() && {return std::move(lres);}
+	};
+	// Computes the same result as act_on_all_ancestors with functor_get, from
+	// the given leaf up to the root, one node per call to step() and prefetching
+	// the next
+	class walk_all_ancestors {
+	private:
+		FUNCTOR_T op;
+		const gutter_base* tree;
+		INDEX_T index;
+		RESULT_T res;
+		bool done;
+	public:
+		walk_all_ancestors(const gutter_base& ro_ba)
+				: op(ro_ba.op), tree(&ro_ba), index(0), res(ro_ba.op()), done(true) {}
+		void start(INDEX_T leaf_no) {
+			res = op();
+			done = false;
+			tree->instrument.walk_begin();
+			index = tree->index_nth_leaf(leaf_no);
+			GUTTER_PREFETCH(&tree->node(index));
+		}
+		// Returns true once the walk has finished
+		bool step() {
+			if (done) return true;
+			tree->instrument.level();
+			tree->instrument.visit(1);
+			gutter_combine<FUNCTOR_T>::into(op, res, tree->node(index));
+			index = index_parent(index);
+			if (index > 0) {
+				GUTTER_PREFETCH(&tree->node(index));
+				return false;
+			}
+			tree->instrument.walk_end();
+			done = true;
+			return true;
 		}
+		const RESULT_T& result() const & {return res;}
+		RESULT_T result() && {return std::move(res);}
 	};
 
+	// Runs the walks of 'k' requests (each passed to WALK_T::start), up to
+	// 'lanes' at a time, stepping each walk in turn so that the cache misses of
+	// each overlap with the work of the others; out[j] is set to the result of
+	// the 'j'th request, and a request equal to its predecessor reuses the
+	// predecessor's result
+	template <typename WALK_T, typename REQUEST_T>
+	void act_interleaved(const REQUEST_T* requests, std::size_t k, RESULT_T* out,
+			unsigned lanes) const {
+		if (lanes == 0) lanes = 1;
+		std::vector<WALK_T> walks(lanes, WALK_T(*this));
+		std::vector<std::size_t> slots(lanes, k);	// = k while a lane is idle
+		std::size_t next = 0;
+		unsigned active = 0;
+		do {
+			for (unsigned l=0; l<lanes; ++l) {
+				if (!walks[l].step())
+					continue;
+				if (slots[l] < k) {
+					out[slots[l]] = walks[l].result();
+					slots[l] = k;
+					--active;
+				}
+				// Refill lane with the next distinct request
+				while (next < k && next > 0 && requests[next] == requests[next-1])
+					++next;
+				if (next < k) {
+					walks[l].start(requests[next]);
+					slots[l] = next++;
+					++active;
+				}
+			}
+		} while (active > 0);
+		for (std::size_t j=1; j<k; ++j) {
+			if (requests[j] == requests[j-1])
+				out[j] = out[j-1];
+		}
+	}
+
 	// Outputs elements in structure to iterable
 	// TODO instead output an iterator to the elements passed
 	template <typename ITER_T>
@@ -236,12 +582,13 @@ protected:
 	private:
 		FUNCTOR_T op;
 		const RESULT_T* const binarray;
+		const LAYOUT_T layout;
 		ITER_T iter;
 	public:
 		functor_get_to_iter(const gutter_base& ro_ba, ITER_T it)
-				: op(ro_ba.op), binarray(ro_ba.heap), iter(it) {}
+				: op(ro_ba.op), binarray(ro_ba.heap), layout(ro_ba.layout), iter(it) {}
 		void operator()(INDEX_T index) {
-			*(iter++) = binarray[index];
+			*(iter++) = binarray[layout.position(index)];
 		}
 		ITER_T iterator() {
 			return iter;
@@ -253,12 +600,13 @@ protected:
 	private:
 		FUNCTOR_T op;
 		RESULT_T* const binarray;
+		const LAYOUT_T layout;
 		ITER_T iter;
 	public:
 		functor_set_from_iter(gutter_base& ro_ba, ITER_T it)
-				: op(ro_ba.op), binarray(ro_ba.heap), iter(it) {}
+				: op(ro_ba.op), binarray(ro_ba.heap), layout(ro_ba.layout), iter(it) {}
 		void operator()(INDEX_T index) {
-			binarray[index] = *(iter++);
+			binarray[layout.position(index)] = *(iter++);
 		}
 		ITER_T iterator() {
 			return iter;
@@ -267,43 +615,176 @@ protected:
 };
 
 #include <limits>
+#include <type_traits>
 
+// - the identity of add is T(), i.e., 0 for arithmetic types, and empty for
+//	 e.g. std::string
 template <typename T>
 struct add {
-	inline T operator()() const {
-		return 0;
+	constexpr T operator()() const {
+		return T();
 	}
-	inline T operator()(T arg1, T arg2) const {
+	constexpr T operator()(const T& arg1, const T& arg2) const {
 		return arg1 + arg2;
 	}
+	// - only for types with +=
+	template <typename U>
+	inline auto combine_into(U& acc, const U& x) const -> decltype(void(acc += x)) {
+		acc += x;
+	}
 };
 template <typename T>
 struct mult {
-	inline T operator()() const {
+	constexpr T operator()() const {
 		return 1;
 	}
-	inline T operator()(T arg1, T arg2) const {
+	constexpr T operator()(const T& arg1, const T& arg2) const {
 		return arg1 * arg2;
 	}
+	// - only for types with *=
+	template <typename U>
+	inline auto combine_into(U& acc, const U& x) const -> decltype(void(acc *= x)) {
+		acc *= x;
+	}
 };
 template <typename T>
 struct min {
-	inline T operator()() const {
+	constexpr T operator()() const {
 		return std::numeric_limits<T>::max();
 	}
-	inline T operator()(T arg1, T arg2) const {
-		return std::min(arg1, arg2);
+	constexpr T operator()(const T& arg1, const T& arg2) const {
+		return (arg2 < arg1) ? arg2 : arg1;	// = std::min, in C++11 constexpr
+	}
+	inline void combine_into(T& acc, const T& x) const {
+		if (x < acc)
+			acc = x;
 	}
 };
 template <typename T>
 struct max {
-	inline T operator()() const {
+	constexpr T operator()() const {
 		return std::numeric_limits<T>::min();
 	}
-	inline T operator()(T arg1, T arg2) const {
-		return std::max(arg1, arg2);
+	constexpr T operator()(const T& arg1, const T& arg2) const {
+		return (arg1 < arg2) ? arg2 : arg1;	// = std::max, in C++11 constexpr
+	}
+	inline void combine_into(T& acc, const T& x) const {
+		if (acc < x)
+			acc = x;
 	}
 };
+
+// Marks functors whose operation is commutative (i.e., op(a,b) == op(b,a)),
+// allowing traversals to combine nodes in any order
+// - add and mult are only commutative over arithmetic types (e.g., add
+//	 concatenates std::string)
+template <typename FUNCTOR_T>
+struct gutter_is_commutative : std::false_type {};
+template <typename T>
+struct gutter_is_commutative<add<T> > : std::is_arithmetic<T> {};
+template <typename T>
+struct gutter_is_commutative<mult<T> > : std::is_arithmetic<T> {};
+template <typename T>
+struct gutter_is_commutative<min<T> > : std::true_type {};
+template <typename T>
+struct gutter_is_commutative<max<T> > : std::true_type {};
+
+// Marks functors whose operation has an inverse (i.e., inverse(op(a,b), b) == a),
+// allowing a range result to be computed from two prefix results
+// - mult has no inverse: 0 cannot be divided back out of a product (nor can
+//	 an integer product that wrapped)
+template <typename FUNCTOR_T>
+struct gutter_inverse : std::false_type {};
+template <typename T>
+struct gutter_inverse<add<T> > : std::true_type {
+	static inline T apply(T res, T x) {
+		return res - x;
+	}
+};
+
+// Detects a functor member combine_into(acc, x), setting acc = op(acc, x) in
+// place
+template <typename FUNCTOR_T, typename RESULT_T>
+class gutter_has_combine_into {
+	template <typename F>
+	static std::true_type test(decltype(std::declval<const F&>().combine_into(
+			std::declval<RESULT_T&>(), std::declval<const RESULT_T&>()))*);
+	template <typename F>
+	static std::false_type test(...);
+public:
+	static const bool value = decltype(test<FUNCTOR_T>(0))::value;
+};
+
+// Combines results in place: where the functor defines combine_into(acc, x)
+// (e.g., for results that hold heap storage, such as a histogram backed by a
+// std::vector, which then keeps its storage rather than being rebuilt on every
+// node), through it; otherwise through op(), moving the accumulated result in
+// - into(): acc = op(acc, x)
+// - into_front(): acc = op(x, acc), in place only for commutative functors
+// - pair(): dst = op(l, r), in place by copying 'l' over 'dst' (which reuses
+//	 the storage of 'dst')
+template <typename FUNCTOR_T>
+struct gutter_combine {
+	template <typename RESULT_T>
+	static inline void into(const FUNCTOR_T& op, RESULT_T& acc, const RESULT_T& x) {
+		into(op, acc, x, std::integral_constant<bool,
+				gutter_has_combine_into<FUNCTOR_T,RESULT_T>::value>());
+	}
+	template <typename RESULT_T>
+	static inline void into_front(const FUNCTOR_T& op, const RESULT_T& x, RESULT_T& acc) {
+		into_front(op, x, acc, std::integral_constant<bool,
+				gutter_has_combine_into<FUNCTOR_T,RESULT_T>::value
+				&& gutter_is_commutative<FUNCTOR_T>::value>());
+	}
+	template <typename RESULT_T>
+	static inline void pair(const FUNCTOR_T& op, RESULT_T& dst,
+			const RESULT_T& l, const RESULT_T& r) {
+		pair(op, dst, l, r, std::integral_constant<bool,
+				gutter_has_combine_into<FUNCTOR_T,RESULT_T>::value>());
+	}
+private:
+	template <typename RESULT_T>
+	static inline void into(const FUNCTOR_T& op, RESULT_T& acc, const RESULT_T& x,
+			std::true_type) {
+		op.combine_into(acc, x);
+	}
+	template <typename RESULT_T>
+	static inline void into(const FUNCTOR_T& op, RESULT_T& acc, const RESULT_T& x,
+			std::false_type) {
+		acc = op(std::move(acc), x);
+	}
+	template <typename RESULT_T>
+	static inline void into_front(const FUNCTOR_T& op, const RESULT_T& x, RESULT_T& acc,
+			std::true_type) {
+		op.combine_into(acc, x);
+	}
+	template <typename RESULT_T>
+	static inline void into_front(const FUNCTOR_T& op, const RESULT_T& x, RESULT_T& acc,
+			std::false_type) {
+		acc = op(x, std::move(acc));
+	}
+	template <typename RESULT_T>
+	static inline void pair(const FUNCTOR_T& op, RESULT_T& dst,
+			const RESULT_T& l, const RESULT_T& r, std::true_type) {
+		dst = l;
+		op.combine_into(dst, r);
+	}
+	template <typename RESULT_T>
+	static inline void pair(const FUNCTOR_T& op, RESULT_T& dst,
+			const RESULT_T& l, const RESULT_T& r, std::false_type) {
+		dst = op(l, r);
+	}
+};
+
+// Identifies the functors in saved files (see gutter_file.h)
+template <typename T>
+struct gutter_file_tag<add<T> > : std::integral_constant<std::uint32_t, 1> {};
+template <typename T>
+struct gutter_file_tag<mult<T> > : std::integral_constant<std::uint32_t, 2> {};
+template <typename T>
+struct gutter_file_tag<min<T> > : std::integral_constant<std::uint32_t, 3> {};
+template <typename T>
+struct gutter_file_tag<max<T> > : std::integral_constant<std::uint32_t, 4> {};
 /*
 template <typename T>
 struct gcd {
@@ -0,0 +1,107 @@
+#ifndef GUTTER_BATCH_H
+#define GUTTER_BATCH_H
+
+#include "gutter_apply.h"
+#include "gutter_retrieve.h"
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// The queries a tree answers in batches, and how (see gutter_batch below)
+template <typename TREE_T>
+struct gutter_batch_traits;
+
+// gutter_retrieve answers ranges of elements, [i1,i2)
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T, typename ALLOC_T,
+		typename STATS_T>
+struct gutter_batch_traits<gutter_retrieve<RESULT_T, FUNCTOR_T, LAYOUT_T, ALLOC_T, STATS_T> > {
+	typedef gutter_retrieve<RESULT_T, FUNCTOR_T, LAYOUT_T, ALLOC_T, STATS_T> tree_type;
+	typedef std::pair<std::size_t, std::size_t> request_type;
+	static void run(const tree_type& tree, const request_type* requests, std::size_t k,
+			RESULT_T* out, unsigned lanes) {
+		tree.accumulate_batch(requests, k, out, lanes);
+	}
+};
+// gutter_apply answers single elements, 'i'
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T, typename ALLOC_T,
+		typename STATS_T>
+struct gutter_batch_traits<gutter_apply<RESULT_T, FUNCTOR_T, LAYOUT_T, ALLOC_T, STATS_T> > {
+	typedef gutter_apply<RESULT_T, FUNCTOR_T, LAYOUT_T, ALLOC_T, STATS_T> tree_type;
+	typedef std::size_t request_type;
+	static void run(const tree_type& tree, const request_type* requests, std::size_t k,
+			RESULT_T* out, unsigned lanes) {
+		tree.get_batch(requests, k, out, lanes);
+	}
+};
+
+/*
+ * This class queues up queries against a tree as they come (e.g., from the
+ * requests of a query service), and answers them all at once: on trees much
+ * larger than the caches, each query walks a chain of dependent cache misses
+ * (one per generation of the tree), so the walks of up to 'lanes' queries are
+ * stepped in turn, each prefetching its next nodes while the others run (see
+ * accumulate_batch of gutter_retrieve, and get_batch of gutter_apply).
+ *	- gutter_batch<gutter_retrieve<...> > queues ranges, submit(i1,i2)
+ *	- gutter_batch<gutter_apply<...> > queues elements, submit(i)
+ *
+ * Queries are answered as of drain(), not submit(), and results come out in
+ * the order the queries were submitted. The tree must outlive the batch.
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- submitting a query
+ *		-> amortized O(1)
+ *	- answering the 'k' queries submitted
+ *		-> O(k*log(n)), 'lanes' walks at a time
+ */
+template <typename TREE_T>
+class gutter_batch {
+	typedef std::size_t INDEX_T;
+	typedef gutter_batch_traits<TREE_T> traits;
+
+public:
+	typedef typename TREE_T::result_type result_type;
+	typedef typename traits::request_type request_type;
+
+private:
+	const TREE_T& tree;
+	unsigned _lanes;
+	std::vector<request_type> requests;
+	std::vector<result_type> results;
+
+public:
+	// Constructor
+	explicit gutter_batch(const TREE_T& t, unsigned lanes=TREE_T::batch_lanes)
+			: tree(t), _lanes(lanes) {}
+	// = the number of queries submitted since the last drain()
+	INDEX_T size() const {
+		return requests.size();
+	}
+	unsigned lanes() const {
+		return _lanes;
+	}
+	void reserve(INDEX_T k) {
+		requests.reserve(k);
+		results.reserve(k);
+	}
+
+	// Access Methods (run in amortized O(1) time)
+	void submit(const request_type& request) {
+		requests.push_back(request);
+	}
+	void submit(INDEX_T i1, INDEX_T i2) {
+		submit(request_type(i1, i2));
+	}
+	// Access Method (runs in O(k*log(n)) time)
+	// - writes the results of the queries submitted, in order, and clears them
+	template <typename ITER_T>
+	ITER_T drain(ITER_T output) {
+		results.resize(requests.size());
+		traits::run(tree, requests.data(), requests.size(), results.data(), _lanes);
+		requests.clear();
+		return std::copy(results.begin(), results.end(), output);
+	}
+};
+
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef GUTTER_DOUBLE_BUFFER_H
+#define GUTTER_DOUBLE_BUFFER_H
+
+#include <atomic>
+#include <thread>
+#include <utility>
+
+/*
+ * This class holds two instances of a gutter class (any tree type providing
+ * clone(), and move construction/assignment): a "front" tree that readers
+ * query, and a "back" tree that a single writer modifies or replaces. Once the
+ * back tree is ready, publishing it swaps the roles of the two trees in one
+ * atomic store; readers already holding the old front tree keep using it until
+ * they release it.
+ *
+ * Readers pin the front tree through a reader handle, and never block. Before
+ * the writer may touch the back tree again after a publish, it waits for the
+ * readers still pinning that tree (i.e., the previous front) to release it.
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- pinning/releasing the front tree
+ *		-> O(1)
+ *	- publishing the back tree
+ *		-> O(1)
+ *	- accessing the back tree
+ *		-> O(1), once the readers of the previous front tree have finished
+ *	- constructing from a tree of 'n' elements
+ *		-> O(n)
+ */
+template <typename TREE_T>
+class gutter_double_buffer {
+	TREE_T trees[2];
+	std::atomic<unsigned> front_no;
+	std::atomic<unsigned> readers[2];
+
+	// Pins the current front tree, returning its number
+	// - sequentially consistent, so that the writer cannot miss a reader that
+	//	 saw the old front number
+	unsigned pin() {
+		while (true) {
+			const unsigned k = front_no.load();
+			readers[k].fetch_add(1);
+			// The front may have been published over in the meantime
+			if (front_no.load() == k)
+				return k;
+			readers[k].fetch_sub(1, std::memory_order_release);
+		}
+	}
+	unsigned back_no() const {
+		return 1 - front_no.load(std::memory_order_relaxed);
+	}
+
+public:
+	// A pinned front tree; the writer does not modify it while it is held
+	class reader {
+		friend class gutter_double_buffer;
+
+		gutter_double_buffer* buffer;
+		unsigned k;
+
+		reader(gutter_double_buffer& source) : buffer(&source), k(source.pin()) {}
+	public:
+		reader(reader&& other) : buffer(other.buffer), k(other.k) {
+			other.buffer = 0;
+		}
+		reader(const reader&) = delete;
+		reader& operator=(const reader&) = delete;
+		~reader() {
+			if (buffer)
+				buffer->readers[k].fetch_sub(1, std::memory_order_release);
+		}
+		const TREE_T& operator*() const {
+			return buffer->trees[k];
+		}
+		const TREE_T* operator->() const {
+			return &buffer->trees[k];
+		}
+	};
+
+	// - both trees start out as copies of the given tree
+	gutter_double_buffer(TREE_T&& initial)
+			: trees{initial.clone(), std::move(initial)}, front_no(0) {
+		readers[0] = 0;
+		readers[1] = 0;
+	}
+	gutter_double_buffer(const gutter_double_buffer&) = delete;
+	gutter_double_buffer& operator=(const gutter_double_buffer&) = delete;
+
+	// Reader Method (safe to call from any thread)
+	reader read() {
+		return reader(*this);
+	}
+
+	// Writer Methods (to be called by a single thread at a time)
+	// - waits for the readers of the back tree to release it
+	TREE_T& back() {
+		const unsigned k = back_no();
+		while (readers[k].load() != 0)
+			std::this_thread::yield();
+		return trees[k];
+	}
+	// - the writer's view of the front tree, which it must not modify
+	const TREE_T& front() const {
+		return trees[front_no.load(std::memory_order_relaxed)];
+	}
+	// Makes the back tree the front tree, and vice versa
+	void publish() {
+		front_no.store(back_no());
+	}
+	// Replaces the back tree with the given one, then publishes it
+	void publish(TREE_T&& fresh) {
+		back() = std::move(fresh);
+		publish();
+	}
+	// Brings the back tree up to date with the front tree (runs in O(n) time)
+	void sync_back() {
+		back() = front().clone();
+	}
+};
+
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef GUTTER_FENWICK_H
+#define GUTTER_FENWICK_H
+
+#include "gutter_base.h"
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+/*
+ * This class provides the interface of gutter_retrieve for functors that are
+ * both commutative and invertible (see gutter_is_commutative, gutter_inverse;
+ * e.g., add), as a Fenwick tree (binary indexed tree): 'n' nodes of storage
+ * rather than 2'n'-1, and a loop of one load and one operation per set bit of
+ * the index.
+ *
+ * Node 'j' (1-based) stores the operation over the elements (j-lowbit(j), j],
+ * where lowbit(j) is the lowest set bit of 'j'. A range result is computed
+ * from two prefix results, as inverse(prefix(i2), prefix(i1)).
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the associative operation over 'k' sequential elements
+ *		-> O(log(n))
+ *	- computing/setting/applying a new value to the 'i'th element
+ *		-> O(log(n))
+ *	- constructing/rebuilding from a sequence of 'n' elements
+ *		-> O(n)
+ */
+template <typename RESULT_T, typename FUNCTOR_T, typename ALLOC_T=std::allocator<RESULT_T> >
+class gutter_fenwick {
+	static_assert(gutter_is_commutative<FUNCTOR_T>::value && gutter_inverse<FUNCTOR_T>::value,
+			"gutter_fenwick requires a commutative, invertible functor");
+
+	typedef std::size_t INDEX_T;
+	typedef gutter_inverse<FUNCTOR_T> inverse;
+
+	INDEX_T _size;
+	FUNCTOR_T op;
+	// Node 'j' is stored at position j-1
+	std::vector<RESULT_T, ALLOC_T> nodes;
+
+	static inline INDEX_T lowbit(INDEX_T j) {
+		return j & (~j+1);
+	}
+	// = the operation over the first 'i' elements
+	inline RESULT_T prefix(INDEX_T i) const {
+		RESULT_T res = op();
+		for (; i>0; i &= i-1)
+			res = op(res, nodes[i-1]);
+		return res;
+	}
+
+	template <typename ITER_T>
+	void build(ITER_T input) {
+		for (INDEX_T j=0; j<_size; ++j, ++input)
+			nodes[j] = *input;
+		// Each node passes its result on to the next node covering it
+		for (INDEX_T j=1; j<=_size; ++j) {
+			const INDEX_T parent = j + lowbit(j);
+			if (parent <= _size)
+				nodes[parent-1] = op(nodes[parent-1], nodes[j-1]);
+		}
+	}
+
+public:
+	// Constructor
+	gutter_fenwick(INDEX_T n, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: _size(n), op(functor), nodes(n, functor(), allocator) {}
+	// Constructors (run in O(n) time)
+	gutter_fenwick(std::initializer_list<RESULT_T> source,
+			FUNCTOR_T functor=FUNCTOR_T(), const ALLOC_T& allocator=ALLOC_T())
+			: _size(source.size()), op(functor), nodes(source.size(), functor(), allocator) {
+		build(source.begin());
+	}
+	template <typename ITER_T, typename=gutter_iterator_category<ITER_T> >
+	gutter_fenwick(ITER_T first, ITER_T last, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: _size(std::distance(first,last)), op(functor),
+			nodes(_size, functor(), allocator) {
+		build(first);
+	}
+	INDEX_T size() const {
+		return _size;
+	}
+
+	// Access Methods (run in O(log(n)) time)
+	RESULT_T operator[](INDEX_T leaf_no) const {
+		// Removes the nodes below 'leaf_no' from the node ending at it
+		const INDEX_T j = leaf_no+1;
+		RESULT_T res = nodes[j-1];
+		for (INDEX_T i=leaf_no, stop=j-lowbit(j); i>stop; i &= i-1)
+			res = inverse::apply(res, nodes[i-1]);
+		return res;
+	}
+	void assign(INDEX_T leaf_no, RESULT_T& x) {
+		RESULT_T delta = inverse::apply(x, (*this)[leaf_no]);
+		apply(leaf_no, delta);
+	}
+	void apply(INDEX_T leaf_no, RESULT_T& x) {
+		for (INDEX_T j=leaf_no+1; j<=_size; j += lowbit(j))
+			nodes[j-1] = op(nodes[j-1], x);
+	}
+	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
+		if (leaf1>=leaf2) return op();
+		return inverse::apply(prefix(leaf2), prefix(leaf1));
+	}
+	// Access Method (runs in O(n) time)
+	template <typename ITER_T>
+	void rebuild(ITER_T first, ITER_T last) {
+		if (INDEX_T(std::distance(first,last)) != _size) //error?
+			return;
+		build(first);
+	}
+};
+
+
+#endif
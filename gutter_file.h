@@ -0,0 +1,251 @@
+#ifndef GUTTER_FILE_H
+#define GUTTER_FILE_H
+/*
+ * This is the on-disk format of the gutter classes, written by their save()
+ * method: a 64-byte header, followed by the raw node storage (i.e., the heap
+ * array, in layout order). Since the storage is written as-is, a saved file can
+ * be mapped back into memory and queried in place, with no deserialization
+ * (see gutter_mapped below, and the open_mmap() methods of the gutter classes).
+ *
+ * The header records everything the storage depends on, so that a file is
+ * never opened as the wrong type of tree:
+ *	- a magic string and format version
+ *	- the number of elements, and the number of nodes of storage
+ *	- the size, alignment and kind (float/signed/unsigned) of RESULT_T
+ *	- tags identifying the functor and the layout (see gutter_file_tag)
+ *	- a checksum of the node storage (64-bit FNV-1a over 8-byte words), which
+ *	  opening only verifies on request, as doing so reads the whole file
+ *
+ * Files are written in the byte order of the host, and are only opened on
+ * hosts of the same byte order (checked through the magic string).
+ */
+
+#include "gutter_layout.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GUTTER_FILE_MMAP 1
+#endif
+
+// Selects the constructors of the gutter classes that take over storage
+// already holding a built tree (e.g., from a saved file), rather than filling it
+struct gutter_adopt_storage {};
+
+// Identifies a functor or layout type in file headers; types without a tag
+// (i.e., a tag of 0) are not checked when a file is opened
+template <typename T>
+struct gutter_file_tag : std::integral_constant<std::uint32_t, 0> {};
+template <>
+struct gutter_file_tag<gutter_layout_bfs> : std::integral_constant<std::uint32_t, 1> {};
+template <std::size_t LEVELS>
+struct gutter_file_tag<gutter_layout_blocked<LEVELS> >
+		: std::integral_constant<std::uint32_t, 0x100+LEVELS> {};
+
+struct gutter_file_header {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t header_bytes;
+	std::uint64_t size;
+	std::uint64_t nodes;
+	std::uint32_t node_bytes;
+	std::uint32_t node_align;
+	std::uint32_t node_kind;	// 'f'loat, 's'igned, 'u'nsigned, or 0
+	std::uint32_t functor_tag;
+	std::uint32_t layout_tag;
+	std::uint32_t reserved;
+	std::uint64_t checksum;
+
+	enum { current_version = 1 };
+
+	static inline std::uint64_t checksum_of(const void* data, std::size_t bytes) {
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		std::uint64_t hash = 14695981039346656037ull;
+		for (; bytes >= 8; bytes -= 8, p += 8) {
+			std::uint64_t word;
+			std::memcpy(&word, p, 8);
+			hash = (hash ^ word) * 1099511628211ull;
+		}
+		for (; bytes > 0; --bytes, ++p)
+			hash = (hash ^ *p) * 1099511628211ull;
+		return hash;
+	}
+
+	template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T>
+	static gutter_file_header describe(std::size_t n, std::size_t node_count) {
+		gutter_file_header header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, "GUTTER", 6);
+		// Byte order mark
+		const std::uint16_t bom = 0x0102;
+		std::memcpy(header.magic+6, &bom, 2);
+		header.version = current_version;
+		header.header_bytes = sizeof(gutter_file_header);
+		header.size = n;
+		header.nodes = node_count;
+		header.node_bytes = sizeof(RESULT_T);
+		header.node_align = alignof(RESULT_T);
+		header.node_kind = std::is_floating_point<RESULT_T>::value ? 'f'
+				: !std::is_integral<RESULT_T>::value ? 0
+				: std::is_signed<RESULT_T>::value ? 's' : 'u';
+		header.functor_tag = gutter_file_tag<FUNCTOR_T>::value;
+		header.layout_tag = gutter_file_tag<LAYOUT_T>::value;
+		return header;
+	}
+	// = whether this header describes the same tree type/size as 'expected'
+	bool matches(const gutter_file_header& expected) const {
+		return std::memcmp(magic, expected.magic, sizeof(magic)) == 0
+			&& version == expected.version
+			&& header_bytes == expected.header_bytes
+			&& size == expected.size && nodes == expected.nodes
+			&& node_bytes == expected.node_bytes && node_align == expected.node_align
+			&& node_kind == expected.node_kind
+			&& (functor_tag == expected.functor_tag || !expected.functor_tag)
+			&& (layout_tag == expected.layout_tag || !expected.layout_tag);
+	}
+};
+static_assert(sizeof(gutter_file_header) == 64, "gutter_file_header must be 64 bytes");
+
+// Writes a header and 'header.nodes' nodes of storage; returns false on failure
+inline bool gutter_file_save(const char* path, gutter_file_header header,
+		const void* storage) {
+	const std::size_t bytes = header.nodes * header.node_bytes;
+	header.checksum = gutter_file_header::checksum_of(storage, bytes);
+	std::FILE* file = std::fopen(path, "wb");
+	if (!file) //error?
+		return false;
+	bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+		&& std::fwrite(storage, 1, bytes, file) == bytes;
+	ok = (std::fclose(file) == 0) && ok;
+	return ok;
+}
+
+/*
+ * This class serves a read-only gutter tree (e.g., gutter_retrieve or
+ * gutter_apply) straight out of a file written by its save() method: the file
+ * is mapped into memory, and the tree is placed over the mapped storage.
+ * Opening runs in O(1) time, pages being read in as queries touch them (or in
+ * O(n) time, if the checksum is verified).
+ *
+ * Opening fails (i.e., the object converts to false) if the file cannot be
+ * read, or does not hold a tree of type 'TREE_T' (or of the expected number of
+ * elements, if given).
+ */
+template <typename TREE_T>
+class gutter_mapped {
+	typedef typename TREE_T::result_type RESULT_T;
+
+	char* mapping;
+	std::size_t length;
+	std::unique_ptr<TREE_T> tree;
+
+	void release() {
+		tree.reset();
+		if (!mapping)
+			return;
+#if defined(GUTTER_FILE_MMAP)
+		munmap(mapping, length);
+#else
+		::operator delete(mapping);
+#endif
+		mapping = 0;
+	}
+	bool map(const char* path) {
+#if defined(GUTTER_FILE_MMAP)
+		const int fd = ::open(path, O_RDONLY);
+		if (fd < 0) //error?
+			return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0 || std::size_t(info.st_size) < sizeof(gutter_file_header)) {
+			::close(fd);
+			return false;
+		}
+		length = info.st_size;
+		void* const addr = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (addr == MAP_FAILED) //error?
+			return false;
+		mapping = static_cast<char*>(addr);
+		return true;
+#else
+		std::FILE* file = std::fopen(path, "rb");
+		if (!file) //error?
+			return false;
+		std::fseek(file, 0, SEEK_END);
+		length = std::ftell(file);
+		std::fseek(file, 0, SEEK_SET);
+		mapping = static_cast<char*>(::operator new(length));
+		const bool ok = std::fread(mapping, 1, length, file) == length;
+		std::fclose(file);
+		return ok && length >= sizeof(gutter_file_header);
+#endif
+	}
+
+public:
+	// - 'n' is the expected number of elements, or 0 to accept any
+	gutter_mapped(const char* path, bool verify=false, std::size_t n=0)
+			: mapping(0), length(0) {
+		if (!map(path)) {
+			release();
+			return;
+		}
+		gutter_file_header header;
+		std::memcpy(&header, mapping, sizeof(header));
+		const std::size_t size = header.size;
+		if (size == 0 || (n && size != n)) { //error?
+			release();
+			return;
+		}
+		const gutter_file_header expected = gutter_file_header::describe<
+				RESULT_T, typename TREE_T::functor_type, typename TREE_T::layout_type
+			>(size, TREE_T::storage_size(size));
+		const std::size_t bytes = header.nodes * header.node_bytes;
+		if (!header.matches(expected)
+				|| length < header.header_bytes + bytes
+				|| (verify && gutter_file_header::checksum_of(
+						mapping+header.header_bytes, bytes) != header.checksum)) {
+			release();
+			return;
+		}
+		// The tree never writes to adopted storage through its const interface
+		RESULT_T* const storage = reinterpret_cast<RESULT_T*>(mapping+header.header_bytes);
+		tree.reset(new TREE_T(size, storage, gutter_adopt_storage()));
+	}
+	gutter_mapped(gutter_mapped&& other)
+			: mapping(other.mapping), length(other.length), tree(std::move(other.tree)) {
+		other.mapping = 0;
+	}
+	gutter_mapped& operator=(gutter_mapped&& other) {
+		std::swap(mapping, other.mapping);
+		std::swap(length, other.length);
+		tree.swap(other.tree);
+		return *this;
+	}
+	gutter_mapped(const gutter_mapped&) = delete;
+	gutter_mapped& operator=(const gutter_mapped&) = delete;
+	~gutter_mapped() {
+		release();
+	}
+
+	explicit operator bool() const {
+		return tree != nullptr;
+	}
+	const TREE_T& operator*() const {
+		return *tree;
+	}
+	const TREE_T* operator->() const {
+		return tree.get();
+	}
+};
+
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef GUTTER_INDEX_H
+#define GUTTER_INDEX_H
+/*
+ * These are the index helpers of the gutter classes, for trees of 'n' elements
+ * whose nodes are addressed by heap-style (BFS) index: the root is 1, the
+ * children of node 'i' are 2'i' and 2'i'+1, and the 2'n'-1 nodes fill the
+ * indices 1 to 2'n'-1. The leaves are the nodes 'n' to 2'n'-1, in order from
+ * the first node of the deepest row, wrapping around to the row above it.
+ *
+ * gutter_base derives from gutter_index, and trees with heaps of their own
+ * (e.g., gutter_retrieve_columns) call it directly, passing their size:
+ *	- parent, left/right child index
+ *	- first index of the row of a node, and ancestor of a node in a given row
+ *	- 'k'th leaf index, and the inverse
+ *	- number of leaves descending from a node
+ *	- the "minimal covering ancestors" of a sequence of leaves, in leaf order
+ */
+
+#include "BitTwiddles.h"
+#include <algorithm>
+#include <cstddef>
+
+struct gutter_index {
+	typedef std::size_t INDEX_T;
+
+	// = the greatest number of minimal covering ancestors of any range
+	static const unsigned max_covering = 2*8*sizeof(INDEX_T)+1;
+
+	static inline INDEX_T index_parent(INDEX_T n) {
+		return n/2;
+	}
+	static inline INDEX_T index_lbranch(INDEX_T n) {
+		return 2*n;
+	}
+	static inline INDEX_T index_rbranch(INDEX_T n) {
+		return 2*n+1;
+	}
+	static inline bool index_islbranch(INDEX_T index) {
+		return !(index%2);
+	}
+	static inline INDEX_T index_first_of_row(INDEX_T index) {
+		// = the greatest power of 2 less than index
+		return msb(index);
+	}
+	static inline INDEX_T index_nth_leaf(INDEX_T n, INDEX_T size) {
+		const INDEX_T index_deepest_lvl_1st = index_first_of_row(2*size-1);
+		return n + index_deepest_lvl_1st
+				- ((n+index_deepest_lvl_1st < 2*size) ? 0 : size);
+	}
+	static inline INDEX_T index_leaf_no(INDEX_T index, INDEX_T size) {
+		// = the inverse of index_nth_leaf
+		const INDEX_T index_deepest_lvl_1st = index_first_of_row(2*size-1);
+		return index - index_deepest_lvl_1st
+				+ ((index < index_deepest_lvl_1st) ? size : 0);
+	}
+	static inline INDEX_T index_ancestor_in_row(INDEX_T index, INDEX_T row_1st) {
+		while (index_parent(index) >= row_1st)
+			index = index_parent(index);
+		return index;
+	}
+	// = the number of leaves descending from (or equal to) the given node
+	static inline INDEX_T index_leaf_count(INDEX_T index, INDEX_T size) {
+		const INDEX_T index_deepest_lvl_1st = index_first_of_row(2*size-1);
+		const INDEX_T scale = index_deepest_lvl_1st / index_first_of_row(index);
+		// Leaves in the deepest row, then in the row above it
+		INDEX_T count = index_overlap(index*scale, (index+1)*scale,
+				index_deepest_lvl_1st, 2*size);
+		if (scale > 1) {
+			count += index_overlap(index*(scale/2), (index+1)*(scale/2),
+					size, index_deepest_lvl_1st);
+		}
+		return count;
+	}
+	static inline INDEX_T index_overlap(INDEX_T a1, INDEX_T a2, INDEX_T b1, INDEX_T b2) {
+		// = the size of the intersection of [a1,a2) and [b1,b2)
+		const INDEX_T lo = std::max(a1,b1), hi = std::min(a2,b2);
+		return (lo < hi) ? hi-lo : 0;
+	}
+	// Writes the minimal covering ancestors of the leaves [leaf1,leaf2) to
+	// 'path' (of max_covering nodes), in leaf order: those of the left bound
+	// in order, then their common ancestor, then those of the right bound in
+	// reverse; returns the number of nodes written
+	static inline unsigned index_min_covering_ancestors(INDEX_T leaf1, INDEX_T leaf2,
+			INDEX_T size, INDEX_T* path) {
+		if (leaf1>=leaf2) return 0;
+		INDEX_T rpath[8*sizeof(INDEX_T)];
+		unsigned length = 0, rlength = 0;
+		INDEX_T i1 = index_nth_leaf(leaf1, size);
+		INDEX_T i2 = index_nth_leaf(leaf2-1, size);	// sets i2 as an inclusive bound
+		while (true) {
+			// Shift left bound up one generation
+			if (i1 != i2 && !index_islbranch(i1))
+				path[length++] = i1++;
+			if (i1 == i2) break;
+			i1 = index_parent(i1);
+			// Shift right bound up one generation
+			if (i1 != i2 && index_islbranch(i2))
+				rpath[rlength++] = i2--;
+			if (i1 == i2) break;
+			i2 = index_parent(i2);
+		}
+		// Left and right bounds have reached a common ancestor
+		path[length++] = i1;
+		while (rlength > 0)
+			path[length++] = rpath[--rlength];
+		return length;
+	}
+};
+
+
+#endif
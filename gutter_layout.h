@@ -0,0 +1,114 @@
+#ifndef GUTTER_LAYOUT_H
+#define GUTTER_LAYOUT_H
+/*
+ * These are the memory layout policies for the gutter classes. The gutter
+ * classes always address their nodes by heap-style (BFS) index, where the root
+ * is 1 and the children of node 'i' are 2'i' and 2'i'+1; a layout policy maps
+ * each such index to a position in the underlying storage.
+ *
+ * Each layout policy provides the following members:
+ *	- a constructor taking the number of gutter elements 'n'
+ *	- position(i): the storage position of the node with heap-style index 'i'
+ *	- storage_size(): the number of storage positions needed to hold the nodes
+ *		with heap-style indices 1 to 2'n'-1
+ *	- contiguous_rows: whether each row of the tree is stored contiguously and
+ *		in order (so that runs of nodes and their children can be processed as
+ *		plain arrays)
+ *
+ * The following layouts are provided:
+ *	- gutter_layout_bfs: nodes stored in BFS order (i.e., the plain heap array)
+ *	- gutter_layout_blocked<LEVELS>: the tree is cut into complete subtrees of
+ *		'LEVELS' generations, each stored contiguously in a block of 2^LEVELS
+ *		positions (e.g., LEVELS=4 packs 15 32-bit nodes into one 64-byte cache
+ *		line); the blocks are themselves stored in BFS order. A root-to-leaf
+ *		path then touches one block per 'LEVELS' generations, rather than one
+ *		cache line per generation below the first few.
+ *		The blocks are aligned to the deepest row of the tree, so that only
+ *		the block holding the root may be cut short; partially filled blocks in
+ *		the deepest block level cost up to about twice the storage of the BFS
+ *		layout.
+ */
+
+#include <cstddef>
+
+inline std::size_t gutter_log2(std::size_t x) {
+	// = the index of the most significant set bit (x > 0)
+#if defined(__GNUC__)
+	return 8*sizeof(unsigned long long)-1 - __builtin_clzll(x);
+#else
+	std::size_t res = 0;
+	while (x >>= 1) ++res;
+	return res;
+#endif
+}
+
+class gutter_layout_bfs {
+private:
+	typedef std::size_t INDEX_T;
+
+	INDEX_T _size;
+public:
+	static const bool contiguous_rows = true;
+
+	gutter_layout_bfs(INDEX_T n) : _size(n) {}
+	inline INDEX_T position(INDEX_T index) const {
+		return index-1;
+	}
+	inline INDEX_T storage_size() const {
+		return 2*_size-1;
+	}
+};
+
+template <unsigned LEVELS=4>
+class gutter_layout_blocked {
+private:
+	typedef std::size_t INDEX_T;
+
+	INDEX_T _size;
+	// = the number of generations missing from the root's block
+	INDEX_T shift;
+
+	// = sum of 2^(LEVELS*j) for j < 'reps' (masked to the relevant block
+	// levels in position())
+	static constexpr INDEX_T repunit(unsigned reps) {
+		return reps == 0 ? 0 : (repunit(reps-1) << LEVELS) | 1;
+	}
+	static constexpr INDEX_T block_mask = repunit(8*sizeof(INDEX_T)/LEVELS);
+
+public:
+	static const bool contiguous_rows = false;
+
+	gutter_layout_blocked(INDEX_T n)
+		: _size(n), shift((LEVELS - (gutter_log2(2*n-1)+1)%LEVELS) % LEVELS) {}
+
+	inline INDEX_T position(INDEX_T index) const {
+		const INDEX_T vdepth = gutter_log2(index) + shift;
+		const INDEX_T vblock_depth = vdepth - vdepth%LEVELS;
+		if (vblock_depth == 0) {
+			// Node lies in the (possibly cut short) root block
+			return index-1;
+		}
+		// Index of the block's root node, and of the node within the block
+		const INDEX_T root_depth = vblock_depth - shift;
+		const INDEX_T local_depth = vdepth - vblock_depth;
+		const INDEX_T root = index >> local_depth;
+		const INDEX_T local = index - ((root-1) << local_depth);
+		// Index of the block among all blocks
+		const INDEX_T blocks_before = 1
+			+ (((block_mask & ((INDEX_T(1)<<vblock_depth)-1)) - 1)
+				>> shift);
+		const INDEX_T block = blocks_before + (root - (INDEX_T(1)<<root_depth));
+		return (block << LEVELS) + local-1;
+	}
+	inline INDEX_T storage_size() const {
+		// The last nodes of the deepest two rows bound all other positions
+		const INDEX_T last = 2*_size-1;
+		const INDEX_T last_of_prev_row = (INDEX_T(1) << gutter_log2(last)) - 1;
+		const INDEX_T pos = position(last);
+		if (last_of_prev_row == 0) return pos+1;
+		const INDEX_T pos_prev_row = position(last_of_prev_row);
+		return (pos > pos_prev_row ? pos : pos_prev_row) + 1;
+	}
+};
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef GUTTER_LAZY_H
+#define GUTTER_LAZY_H
+
+#include "gutter_base.h"
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/*
+ * This class effectively stores an array of elements, but optimizes to both
+ * quickly apply values via one associative operation (the "update", e.g. add)
+ * over a continuous range of elements, and quickly return another associative
+ * operation (the "combine", e.g. sum/min/max) over a continuous range of
+ * elements.
+ *
+ * Each internal node stores the combined result of its descendants, as well as
+ * a pending update that has been applied to the node but not yet to its
+ * children; pending updates are pushed down only along the paths that an
+ * operation actually visits.
+ *
+ * The update must distribute over the combine, i.e. an update applied to
+ * a combined result must equal the combined result of the updated elements
+ * (see gutter_lazy_update below, e.g. add over sum is scaled by leaf count).
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the combine operation over 'k' sequential elements
+ *		-> O(log(n))
+ *	- applying a value via the update operation to 'k' sequential elements
+ *		-> O(log(n))
+ *	- computing/setting the 'i'th element
+ *		-> O(log(n))
+ *	- constructing from a sequence of 'n' elements
+ *		-> O(n)
+ */
+
+// Applies an update value 'x' to the combined result 'res' of 'count' elements
+template <typename COMBINE_T, typename UPDATE_T>
+struct gutter_lazy_update {
+	template <typename RESULT_T>
+	static inline RESULT_T apply(const UPDATE_T& upd, const RESULT_T& res,
+			const RESULT_T& x, std::size_t) {
+		return upd(res, x);
+	}
+};
+template <typename T>
+struct gutter_lazy_update<add<T>, add<T> > {
+	static inline T apply(const add<T>& upd, const T& res, const T& x,
+			std::size_t count) {
+		return upd(res, x*T(count));
+	}
+};
+
+template <typename RESULT_T, typename COMBINE_T, typename UPDATE_T=COMBINE_T,
+		typename LAYOUT_T=gutter_layout_bfs, typename ALLOC_T=std::allocator<RESULT_T> >
+class gutter_lazy
+		: public gutter_base<RESULT_T, COMBINE_T, LAYOUT_T, ALLOC_T> {
+
+	typedef gutter_base<RESULT_T, COMBINE_T, LAYOUT_T, ALLOC_T> base;
+	typedef typename base::INDEX_T INDEX_T;
+	typedef gutter_lazy_update<COMBINE_T, UPDATE_T> update_rule;
+
+	UPDATE_T upd;
+	// Pending updates for the children of each internal node
+	std::vector<RESULT_T, ALLOC_T> tags;
+
+	inline void apply_tag(INDEX_T index, const RESULT_T& x) {
+		this->node(index) = update_rule::apply(
+				upd, this->node(index), x, this->index_leaf_count(index)
+			);
+		if (index < this->_size)
+			tags[index] = upd(tags[index], x);
+	}
+	inline void push_down(INDEX_T index) {
+		apply_tag(this->index_lbranch(index), tags[index]);
+		apply_tag(this->index_rbranch(index), tags[index]);
+		tags[index] = upd();
+	}
+	inline void pull_up(INDEX_T index) {
+		this->node(index) = update_rule::apply(
+				upd,
+				this->op(
+					this->node(this->index_lbranch(index)),
+					this->node(this->index_rbranch(index))
+				),
+				tags[index], this->index_leaf_count(index)
+			);
+	}
+
+	class functor_apply_tag {
+	private:
+		gutter_lazy& tree;
+		const RESULT_T input;
+	public:
+		functor_apply_tag(gutter_lazy& lazy, const RESULT_T& in)
+			: tree(lazy), input(in) {}
+		void operator()(INDEX_T index) {
+			tree.apply_tag(index, input);
+		}
+	};
+	class functor_push_down {
+	private:
+		gutter_lazy& tree;
+	public:
+		functor_push_down(gutter_lazy& lazy) : tree(lazy) {}
+		void operator()(INDEX_T index) {
+			tree.push_down(index);
+		}
+	};
+	class functor_pull_up {
+	private:
+		gutter_lazy& tree;
+	public:
+		functor_pull_up(gutter_lazy& lazy) : tree(lazy) {}
+		void operator()(INDEX_T index) {
+			tree.pull_up(index);
+		}
+	};
+	// Applies the pending updates of a leaf's ancestors to its value, oldest
+	// (i.e., deepest) first
+	class functor_get_pending {
+	private:
+		const gutter_lazy& tree;
+		RESULT_T res;
+	public:
+		functor_get_pending(const gutter_lazy& lazy, const RESULT_T& leaf)
+			: tree(lazy), res(leaf) {}
+		void operator()(INDEX_T index) {
+			res = update_rule::apply(tree.upd, res, tree.tags[index], 1);
+		}
+		const RESULT_T& result() {return res;}
+	};
+
+	// Pushes all pending updates down to the given leaves
+	inline void push_down_to(INDEX_T leaf1, INDEX_T leaf2) {
+		base::template act_on_all_ancestors_rootdown(
+				this->index_parent(leaf1), functor_push_down(*this));
+		base::template act_on_all_ancestors_rootdown(
+				this->index_parent(leaf2), functor_push_down(*this));
+	}
+	// Recomputes all ancestors of the given leaves
+	inline void pull_up_from(INDEX_T leaf1, INDEX_T leaf2) {
+		base::template act_on_all_ancestors_leafup(
+				this->index_parent(leaf1), functor_pull_up(*this));
+		base::template act_on_all_ancestors_leafup(
+				this->index_parent(leaf2), functor_pull_up(*this));
+	}
+
+	template <typename ITER_T>
+	void build(ITER_T input) {
+		base::template act_on_leaves_in_order(
+				this->index_nth_leaf(0), this->index_nth_leaf(this->_size-1),
+				typename base::template functor_set_from_iter<ITER_T>(*this,input)
+			);
+		for (INDEX_T i=this->_size-1; i>0; --i) {
+			pull_up(i);
+		}
+	}
+
+	gutter_lazy(const gutter_lazy& source, typename base::clone_tag tag)
+			: base(source,tag), upd(source.upd), tags(source.tags) {}
+
+public:
+	// Constructors
+	gutter_lazy(INDEX_T n, COMBINE_T combine=COMBINE_T(), UPDATE_T update=UPDATE_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: base(n,combine,allocator), upd(update), tags(n, update(), allocator) {
+		std::fill(this->heap, this->heap+this->layout.storage_size(), this->op());
+	}
+	// Constructors (run in O(n) time)
+	template <typename ITER_T, typename=gutter_iterator_category<ITER_T> >
+	gutter_lazy(ITER_T first, ITER_T last,
+			COMBINE_T combine=COMBINE_T(), UPDATE_T update=UPDATE_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: base(std::distance(first,last),combine,allocator), upd(update),
+			tags(this->_size, update(), allocator) {
+		build(first);
+	}
+	gutter_lazy(std::initializer_list<RESULT_T> source,
+			COMBINE_T combine=COMBINE_T(), UPDATE_T update=UPDATE_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: base(source.size(),combine,allocator), upd(update),
+			tags(source.size(), update(), allocator) {
+		build(source.begin());
+	}
+	// Deep copy (runs in O(n) time)
+	gutter_lazy clone() const {
+		return gutter_lazy(*this, typename base::clone_tag());
+	}
+	void swap(gutter_lazy& other) {
+		base::swap(other);
+		std::swap(upd, other.upd);
+		tags.swap(other.tags);
+	}
+	// Access Methods (run in O(log(n)) time)
+	RESULT_T operator[](INDEX_T leaf_no) const {
+		leaf_no = this->index_nth_leaf(leaf_no);
+		return base::template act_on_all_ancestors_leafup(
+				this->index_parent(leaf_no),
+				functor_get_pending(*this, this->node(leaf_no))
+			).result();
+	}
+	void assign(INDEX_T leaf_no, const RESULT_T& x) {
+		leaf_no = this->index_nth_leaf(leaf_no);
+		base::template act_on_all_ancestors_rootdown(
+				this->index_parent(leaf_no), functor_push_down(*this));
+		this->node(leaf_no) = x;
+		base::template act_on_all_ancestors_leafup(
+				this->index_parent(leaf_no), functor_pull_up(*this));
+	}
+	void apply(INDEX_T i1, INDEX_T i2, const RESULT_T& x) {
+		if (i1>=i2) return;
+		const INDEX_T leaf1 = this->index_nth_leaf(i1);
+		const INDEX_T leaf2 = this->index_nth_leaf(i2-1);
+		push_down_to(leaf1, leaf2);
+		// Each covering node takes the same tag, so their order does not matter
+		base::template act_on_min_covering_ancestors(
+				i1,i2, functor_apply_tag(*this, x));
+		pull_up_from(leaf1, leaf2);
+	}
+	// - pushes pending updates down along the range boundaries, hence non-const
+	RESULT_T accumulate(INDEX_T i1, INDEX_T i2) {
+		if (i1>=i2) return this->op();
+		push_down_to(this->index_nth_leaf(i1), this->index_nth_leaf(i2-1));
+		// Combines in leaf order, as the combine need not be commutative
+		typename base::walk_min_covering_ancestors walk(*this);
+		walk.start(i1, i2);
+		while (!walk.step()) {}
+		return std::move(walk).result();
+	}
+};
+
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef GUTTER_OFFLOAD_H
+#define GUTTER_OFFLOAD_H
+
+#include "gutter_base.h"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#if defined(GUTTER_OFFLOAD_TARGET)
+#pragma omp declare target
+#endif
+// = the operation over the elements [leaf1,leaf2), by the "minimal covering
+// ancestors" walk of gutter_base over nodes in heap-index order (node 'i' at
+// nodes[i-1]), where 'deepest' is the index of the first node of the deepest
+// row; left/right bound results are kept in leaf order
+template <typename RESULT_T, typename FUNCTOR_T>
+inline RESULT_T gutter_offload_walk(const RESULT_T* nodes, std::size_t size,
+		std::size_t deepest, const FUNCTOR_T& op, std::size_t leaf1, std::size_t leaf2) {
+	if (leaf1 >= leaf2) return op();
+	std::size_t i1 = leaf1 + deepest - ((leaf1+deepest < 2*size) ? 0 : size);
+	std::size_t i2 = (leaf2-1) + deepest - ((leaf2-1+deepest < 2*size) ? 0 : size);
+	RESULT_T lres = op(), rres = op();
+	while (i1 != i2) {
+		// Shift left bound up one generation
+		if (i1 & 1) {
+			lres = op(lres, nodes[i1++ - 1]);
+			if (i1 == i2) break;
+		}
+		i1 /= 2;
+		// Shift right bound up one generation
+		if (i1 == i2) break;
+		if (!(i2 & 1)) {
+			rres = op(nodes[i2-- - 1], rres);
+			if (i1 == i2) break;
+		}
+		i2 /= 2;
+	}
+	// Left and right bounds have reached a common ancestor
+	return op(op(lres, nodes[i1-1]), rres);
+}
+#if defined(GUTTER_OFFLOAD_TARGET)
+#pragma omp end declare target
+#endif
+
+/*
+ * This class answers large batches of range queries against a tree that no
+ * longer changes (e.g., nightly analytics over a built gutter_retrieve), one
+ * range per thread, across all cores or on an accelerator.
+ *
+ * The nodes of the tree are copied once, in heap-index order (whatever the
+ * layout of the tree), into one array of 2'n'-1 nodes; with offloading, that
+ * array is also copied onto the device once, for the lifetime of the object,
+ * and each batch only transfers its ranges and results. Each range is
+ * evaluated by the same walk as gutter_retrieve::accumulate (see
+ * gutter_offload_walk), so results match it exactly.
+ *
+ * Batches run through the first backend available:
+ *	- with GUTTER_OFFLOAD_TARGET defined, and OpenMP offloading enabled (e.g.,
+ *	  -fopenmp -foffload=nvptx-none for GCC, or -fopenmp
+ *	  -fopenmp-targets=nvptx64 for Clang): an OpenMP target region on the
+ *	  default device (OpenMP runs it on the host if there is no device)
+ *	- with OpenMP (-fopenmp): a parallel loop over the batch, on the host
+ *	- otherwise: a serial loop over the batch
+ *
+ * 'RESULT_T' must be trivially copyable, and 'FUNCTOR_T' must be callable in
+ * device code when offloading, as are add, mult, min and max.
+ *
+ * OPERATIONS & COMPLEXITY (for 'T' threads)
+ * 	- copying the tree (and uploading it)
+ *		-> O(n)
+ *	- computing the associative operation over each of 'k' ranges
+ *		-> O(k*log(n)/T)
+ */
+template <typename RESULT_T, typename FUNCTOR_T>
+class gutter_offload {
+	static_assert(std::is_trivially_copyable<RESULT_T>::value,
+			"gutter_offload requires a trivially copyable RESULT_T");
+
+	typedef std::size_t INDEX_T;
+
+	INDEX_T _size;
+	INDEX_T deepest;	// = the index of the first node of the deepest row
+	FUNCTOR_T op;
+	std::vector<RESULT_T> nodes;	// node 'i' at nodes[i-1]
+
+	inline void upload() {
+#if defined(GUTTER_OFFLOAD_TARGET)
+		const RESULT_T* const p = nodes.data();
+		const std::size_t count = nodes.size();
+		#pragma omp target enter data map(to: p[0:count])
+#endif
+	}
+	inline void release() {
+#if defined(GUTTER_OFFLOAD_TARGET)
+		const RESULT_T* const p = nodes.data();
+		const std::size_t count = nodes.size();
+		#pragma omp target exit data map(delete: p[0:count])
+#endif
+	}
+
+public:
+	typedef RESULT_T result_type;
+	typedef FUNCTOR_T functor_type;
+
+	// Constructor (runs in O(n) time)
+	// - from any tree with the interface of gutter_base (e.g., gutter_retrieve),
+	//	 of the same element type and functor
+	template <typename TREE_T>
+	explicit gutter_offload(const TREE_T& tree, FUNCTOR_T functor=FUNCTOR_T())
+			: _size(tree.size()),
+			deepest(tree.size() > 0 ? INDEX_T(1) << gutter_log2(2*tree.size()-1) : 0),
+			op(functor) {
+		static_assert(std::is_same<typename TREE_T::result_type, RESULT_T>::value
+				&& std::is_same<typename TREE_T::functor_type, FUNCTOR_T>::value,
+				"gutter_offload needs a tree of the same element type and functor");
+		if (_size == 0)
+			return;
+		const typename TREE_T::layout_type layout(_size);
+		nodes.resize(2*_size-1);
+		for (INDEX_T i=1; i<2*_size; ++i)
+			nodes[i-1] = tree.data()[layout.position(i)];
+		upload();
+	}
+	gutter_offload(const gutter_offload&) = delete;
+	gutter_offload& operator=(const gutter_offload&) = delete;
+	~gutter_offload() {
+		release();
+	}
+	INDEX_T size() const {
+		return _size;
+	}
+	// = whether batches run on a device (rather than on the host)
+	static bool offloaded() {
+#if defined(GUTTER_OFFLOAD_TARGET)
+		return omp_get_num_devices() > 0;
+#else
+		return false;
+#endif
+	}
+
+	// Access Method (runs in O(log(n)) time, on the host)
+	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
+		if (_size == 0) return op();
+		return gutter_offload_walk(nodes.data(), _size, deepest, op, leaf1, leaf2);
+	}
+	// Access Method (runs in O(k*log(n)/T) time)
+	// - computes out[j] = accumulate(ranges[j].first, ranges[j].second), with
+	//	 'out' a host buffer of 'k' results
+	void accumulate_batch(const std::pair<INDEX_T,INDEX_T>* ranges, std::size_t k,
+			RESULT_T* out) const {
+		if (_size == 0) { //error?
+			for (std::size_t j=0; j<k; ++j)
+				out[j] = op();
+			return;
+		}
+		const RESULT_T* const p = nodes.data();
+		const INDEX_T size = _size, first = deepest;
+		const FUNCTOR_T f = op;
+		const std::ptrdiff_t count = std::ptrdiff_t(k);
+#if defined(GUTTER_OFFLOAD_TARGET)
+		#pragma omp target teams distribute parallel for \
+				map(to: ranges[0:k]) map(from: out[0:k]) firstprivate(size, first, f)
+#elif defined(_OPENMP)
+		#pragma omp parallel for schedule(static)
+#endif
+		for (std::ptrdiff_t j=0; j<count; ++j) {
+			out[j] = gutter_offload_walk(p, size, first, f,
+					ranges[j].first, ranges[j].second);
+		}
+	}
+};
+
+
+#endif
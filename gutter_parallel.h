@@ -0,0 +1,113 @@
+#ifndef GUTTER_PARALLEL_H
+#define GUTTER_PARALLEL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * This class is a fixed-size pool of worker threads, used by the gutter classes
+ * to fan work out across cores.
+ *
+ * run(k, task) calls task(0), ..., task(k-1) across the workers and the calling
+ * thread, and returns once all calls have finished; tasks are handed out one
+ * at a time, so that uneven tasks balance out. Each call to run() queues its
+ * own batch of tasks, so concurrent calls share the workers rather than wait
+ * on each other; since the caller runs its own tasks as well, a task may also
+ * call run() on its own pool.
+ */
+class gutter_thread_pool {
+	// The tasks of one call to run() (written under 'lock')
+	struct batch {
+		const std::function<void(std::size_t)>& task;
+		const std::size_t count;
+		std::size_t next;	// next task to hand out
+		std::size_t finished;
+	};
+
+	std::vector<std::thread> workers;
+	std::mutex lock;
+	std::condition_variable wake, idle;
+	std::deque<batch*> pending;	// batches with tasks not yet handed out
+	bool stopping;
+
+	// Hands out the next task of 'b' as 'k'; returns false if none are left
+	// - 'lock' must be held
+	bool take(batch& b, std::size_t& k) {
+		if (b.next == b.count)
+			return false;
+		k = b.next++;
+		if (b.next == b.count)
+			pending.erase(std::find(pending.begin(), pending.end(), &b));
+		return true;
+	}
+	// Runs task 'k' of 'b' outside of 'lock'
+	void run_task(batch& b, std::size_t k, std::unique_lock<std::mutex>& guard) {
+		guard.unlock();
+		b.task(k);
+		guard.lock();
+		if (++b.finished == b.count)
+			idle.notify_all();
+	}
+	void work() {
+		std::unique_lock<std::mutex> guard(lock);
+		while (true) {
+			wake.wait(guard, [&]{ return stopping || !pending.empty(); });
+			if (stopping)
+				return;
+			batch& b = *pending.front();
+			std::size_t k;
+			take(b, k);
+			run_task(b, k, guard);
+		}
+	}
+
+public:
+	// - 'threads' counts the calling thread, so 'threads'-1 workers are started
+	explicit gutter_thread_pool(std::size_t threads=std::thread::hardware_concurrency())
+			: stopping(false) {
+		for (std::size_t t=1; t<threads; ++t)
+			workers.emplace_back(&gutter_thread_pool::work, this);
+	}
+	gutter_thread_pool(const gutter_thread_pool&) = delete;
+	gutter_thread_pool& operator=(const gutter_thread_pool&) = delete;
+	~gutter_thread_pool() {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::size_t t=0; t<workers.size(); ++t)
+			workers[t].join();
+	}
+	std::size_t size() const {
+		return workers.size()+1;
+	}
+
+	template <typename F>
+	void run(std::size_t k, F functor) {
+		if (k == 0)
+			return;
+		if (workers.empty() || k == 1) {
+			for (std::size_t j=0; j<k; ++j)
+				functor(j);
+			return;
+		}
+		const std::function<void(std::size_t)> task(functor);
+		batch b = {task, k, 0, 0};
+		std::unique_lock<std::mutex> guard(lock);
+		pending.push_back(&b);
+		wake.notify_all();
+		for (std::size_t j; take(b, j); )
+			run_task(b, j, guard);
+		// The workers may still be running the last tasks of the batch
+		idle.wait(guard, [&]{ return b.finished == b.count; });
+	}
+};
+
+#endif
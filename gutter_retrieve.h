@@ -2,8 +2,14 @@
 #define GUTTER_RETRIEVE_H
 
 #include "gutter_base.h"
+#include "gutter_parallel.h"
+#include "gutter_simd.h"
 #include <algorithm>
 #include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 /*
  * This class effectively stores an array of elements, but optimizes to
@@ -15,62 +21,382 @@
  *		-> O(log(n))
  *	- setting a new value to the 'i'th element
  *		-> O(log(n))
+ *	- finding the first element at which a monotone predicate over a growing
+ *	  range (e.g., a threshold on a prefix sum) holds
+ *		-> O(log(n)), in one pass over the stored ancestors
+ *	- setting/applying new values to 'k' arbitrary elements at once
+ *		-> O(k*log(k)+k*log(n/k))
  *	- setting a collection of 'k' sequential elements
- *		-> O(k+log(n)-log(k))
+ *		-> O(k+log(n)-log(k)), with the ancestors recomputed one row at a time
+ *		   (vectorized for add/min/max over arithmetic types, see gutter_simd.h)
+ *	- constructing/rebuilding from a sequence of 'n' elements
+ *		-> O(n)
+ *
+ * Bulk construction/rebuilding, and setting a large collection of sequential
+ * elements, may also be split across the 'T' threads of a gutter_thread_pool
+ * (see gutter_parallel.h), in chunks of at least 'grain' elements each:
+ *	- building splits the leaves into subtrees of about 'grain' leaves, builds
+ *	  each subtree independently, then finishes the top rows serially
+ *		-> O(n/T+n/grain)
+ *	- setting 'k' sequential elements splits each row of ancestors wider than
+ *	  'grain' nodes into chunks (rows are updated one after the other)
+ *		-> O(k/T+log(n)*grain)
+ *
+ * The work done by each operation (walks, nodes visited, levels traversed, and
+ * optionally hardware counters) can be counted by passing an instrumentation
+ * policy as 'STATS_T' (see gutter_stats.h), and read back through stats(); the
+ * default policy counts nothing, at no cost.
  */
-template <typename RESULT_T, typename FUNCTOR_T>
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T=gutter_layout_bfs,
+		typename ALLOC_T=std::allocator<RESULT_T>, typename STATS_T=gutter_stats_none>
 class gutter_retrieve
-		: public gutter_base<RESULT_T, FUNCTOR_T> {
+		: public gutter_base<RESULT_T, FUNCTOR_T, LAYOUT_T, ALLOC_T, STATS_T> {
 
-	typedef gutter_base<RESULT_T, FUNCTOR_T> base;
+	typedef gutter_base<RESULT_T, FUNCTOR_T, LAYOUT_T, ALLOC_T, STATS_T> base;
 	typedef typename base::INDEX_T INDEX_T;
 
 	class functor_update_parent {
 	private:
 		RESULT_T* const binarray;
+		const LAYOUT_T layout;
 		FUNCTOR_T op;
 	public:
-		functor_update_parent(RESULT_T* array, FUNCTOR_T operation)
-			: op(operation), binarray(array) {}
+		functor_update_parent(gutter_retrieve& tree)
+			: binarray(tree.heap), layout(tree.layout), op(tree.op) {}
 		void operator()(INDEX_T index) {
-			binarray[index] = op(
-					binarray[base::index_lbranch(index)],
-					binarray[base::index_rbranch(index)]
+			gutter_combine<FUNCTOR_T>::pair(op,
+					binarray[layout.position(index)],
+					binarray[layout.position(base::index_lbranch(index))],
+					binarray[layout.position(base::index_rbranch(index))]
 				);
 		}
+		// Updates the run of nodes [j1,j2] within a row
+		void operator()(INDEX_T j1, INDEX_T j2) {
+			update_row(j1, j2, std::integral_constant<bool, LAYOUT_T::contiguous_rows>());
+		}
+	private:
+		void update_row(INDEX_T j1, INDEX_T j2, std::false_type) {
+			for (; j1<=j2; ++j1)
+				(*this)(j1);
+		}
+		void update_row(INDEX_T j1, INDEX_T j2, std::true_type) {
+			// Children of a contiguous run of nodes are also a contiguous run
+			gutter_simd_reduce_pairs(op,
+					binarray+layout.position(j1),
+					binarray+layout.position(base::index_lbranch(j1)),
+					j2-j1+1
+				);
+		}
+	};
+
+	// Writes the leaves from an iterator in one sequential pass, then fills
+	// every internal node from its children in one reverse-order pass, one row
+	// at a time (children always have greater indices than their parents)
+	template <typename ITER_T>
+	ITER_T build(ITER_T input) {
+		input = base::template act_on_leaves_in_order(
+				this->index_nth_leaf(0), this->index_nth_leaf(this->_size-1),
+				typename base::template functor_set_from_iter<ITER_T>(*this,input)
+			).iterator();
+		if (this->_size > 1) {
+			functor_update_parent update(*this);
+			for (INDEX_T i=this->index_first_of_row(this->_size-1); i>0; i/=2)
+				update(i, std::min(2*i-1, this->_size-1));
+		}
+		return input;
+	}
+
+	// Updates each run of nodes [j1,j2] within a row in chunks of 'grain'
+	// nodes, across a thread pool
+	class functor_update_parent_parallel {
+	private:
+		functor_update_parent update;
+		gutter_thread_pool& pool;
+		const INDEX_T grain;
+	public:
+		functor_update_parent_parallel(gutter_retrieve& tree,
+				gutter_thread_pool& threads, INDEX_T g)
+			: update(tree), pool(threads), grain(g) {}
+		void operator()(INDEX_T j1, INDEX_T j2) {
+			if (j2-j1 < grain) {
+				update(j1, j2);
+				return;
+			}
+			pool.run((j2-j1+grain) / grain, [&](std::size_t c) {
+				functor_update_parent chunk(update);
+				chunk(j1+c*grain, std::min(j2, j1+(c+1)*grain-1));
+			});
+		}
+	};
+
+	// Writes the leaves [l1,l2) from an iterator positioned at leaf 'l1', in
+	// the order of act_on_leaves_in_order but without instrumentation (the
+	// instrument is not thread-safe)
+	template <typename ITER_T>
+	void set_leaves(INDEX_T l1, INDEX_T l2, ITER_T input) {
+		INDEX_T i = this->index_nth_leaf(l1);
+		for (INDEX_T j=l1; j<l2; ++j, ++input) {
+			if (i == 2*this->_size)
+				i = this->index_parent(i);	// wraps around to the row above
+			this->node(i++) = *input;
+		}
+	}
+	// - the work of the pool threads is counted by the calling thread, as one
+	//	 walk visiting each chunk of leaves at once
+	template <typename ITER_T>
+	void set_leaves(INDEX_T l1, INDEX_T l2, ITER_T input,
+			gutter_thread_pool& pool, INDEX_T grain) {
+		const gutter_stats_scope<STATS_T> scope(this->instrument);
+		const std::size_t chunks = (l2-l1 + grain-1) / grain;
+		pool.run(chunks, [&](std::size_t c) {
+			const INDEX_T j1 = l1 + c*grain;
+			set_leaves(j1, std::min(l2, j1+grain), std::next(input, j1-l1));
+		});
+		this->instrument.level();
+		if (this->index_nth_leaf(l2-1) < this->index_nth_leaf(l1))
+			this->instrument.level();	// the leaves wrap around to the row above
+		for (std::size_t c=0; c<chunks; ++c)
+			this->instrument.visit(std::min(l2, l1+(c+1)*grain) - (l1+c*grain));
+	}
+	// Recomputes the internal nodes descending from (or equal to) the nodes
+	// [j1,j2) of one row, deepest row first
+	void update_subtrees(INDEX_T j1, INDEX_T j2) {
+		functor_update_parent update(*this);
+		INDEX_T scale = 1;
+		while (2*j1*scale < this->_size)
+			scale *= 2;
+		for (; scale > 0; scale /= 2) {
+			const INDEX_T lo = j1*scale, hi = std::min(j2*scale, this->_size);
+			if (lo < hi)
+				update(lo, hi-1);
+		}
+	}
+	template <typename ITER_T>
+	ITER_T build(ITER_T input, gutter_thread_pool& pool, INDEX_T grain) {
+		set_leaves(0, this->_size, input, pool, grain);
+		if (this->_size > 1) {
+			// Builds one subtree of about 'grain' leaves per task, from the
+			// first row with enough nodes, then the rows above it serially
+			const INDEX_T deepest = this->index_first_of_row(this->_size-1);
+			INDEX_T row_1st = 1;
+			while (row_1st < deepest && row_1st*grain < this->_size)
+				row_1st *= 2;
+			const INDEX_T row_end = std::min(2*row_1st, this->_size);
+			pool.run(row_end-row_1st, [&](std::size_t j) {
+				update_subtrees(row_1st+j, row_1st+j+1);
+			});
+			functor_update_parent update(*this);
+			for (INDEX_T i=row_1st/2; i>0; i/=2)
+				update(i, 2*i-1);
+		}
+		return std::next(input, this->_size);
+	}
+
+	class functor_not_less {
+	private:
+		const RESULT_T target;
+	public:
+		functor_not_less(const RESULT_T& t) : target(t) {}
+		bool operator()(const RESULT_T& res) const {
+			return !(res < target);
+		}
 	};
+	// Descends from a node for which pred(op(res, node)) holds, to its first
+	// leaf for which pred holds on the result so far; returns the leaf number
+	template <typename PRED_T>
+	INDEX_T descend_to_first(INDEX_T index, RESULT_T res, PRED_T pred) const {
+		RESULT_T lres = this->op();
+		while (index < this->_size) {
+			const INDEX_T lbranch = this->index_lbranch(index);
+			lres = res;	// reuses the storage of 'lres'
+			gutter_combine<FUNCTOR_T>::into(this->op, lres, this->node(lbranch));
+			if (pred(lres)) {
+				index = lbranch;
+			} else {
+				std::swap(res, lres);
+				index = this->index_rbranch(index);
+			}
+		}
+		return this->index_leaf_no(index);
+	}
+
+	// Keeps the results of the left and right bounds apart, so that elements
+	// are combined in order
+	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2, std::false_type) const {
+		typename base::walk_min_covering_ancestors walk(*this);
+		walk.start(leaf1, leaf2);
+		while (!walk.step()) {}
+		return std::move(walk).result();
+	}
+	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2, std::true_type) const {
+		if (leaf1>=leaf2) return this->op();
+		// One walk, even when the range wraps into two spans
+		const gutter_stats_scope<STATS_T> scope(this->instrument);
+		const INDEX_T i1 = this->index_nth_leaf(leaf1);
+		const INDEX_T i2 = this->index_nth_leaf(leaf2-1)+1;	// exclusive bound
+		if (i1 < i2)
+			return accumulate_span(i1, i2);
+		// Range wraps from the deepest row around to the row above it
+		return this->op(
+				accumulate_span(i1, 2*this->_size),
+				accumulate_span(this->_size, i2)
+			);
+	}
+	// Combines the nodes covering the heap indices [i1,i2) of the bottom rows,
+	// in no particular order; both bounds are always loaded, and conditionally
+	// combined with the identity, so the loop has no data-dependent branches
+	RESULT_T accumulate_span(INDEX_T i1, INDEX_T i2) const {
+		const RESULT_T identity = this->op();
+		RESULT_T res = identity;
+		for (; i1 < i2; i1 = this->index_parent(i1), i2 = this->index_parent(i2)) {
+			this->instrument.level();
+			this->instrument.visit(2);
+			const RESULT_T left = this->node(i1);
+			const RESULT_T right = this->node(i2-1);
+			res = this->op(res, (i1&1) ? left : identity);
+			res = this->op(res, (i2&1) ? right : identity);
+			i1 += i1&1;
+			i2 -= i2&1;
+		}
+		return res;
+	}
+
+	gutter_retrieve(const gutter_retrieve& source, typename base::clone_tag tag)
+			: base(source,tag) {}
 
 public:
 	// Constructor
-	gutter_retrieve(INDEX_T n, FUNCTOR_T functor=FUNCTOR_T())
-			: base(n,functor) {
-		std::fill(this->heap+1,this->heap+(2*this->_size), this->op());
+	gutter_retrieve(INDEX_T n, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: base(n,functor,allocator) {
+		std::fill(this->heap, this->heap+this->layout.storage_size(), this->op());
+	}
+	// - 'storage' must hold storage_size(n) nodes, and outlive the tree
+	gutter_retrieve(INDEX_T n, RESULT_T* storage, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: base(n,functor,storage,allocator) {
+		std::fill(this->heap, this->heap+this->layout.storage_size(), this->op());
+	}
+	// - 'storage' already holds a built tree of 'n' elements (e.g., from a file)
+	gutter_retrieve(INDEX_T n, RESULT_T* storage, gutter_adopt_storage,
+			FUNCTOR_T functor=FUNCTOR_T(), const ALLOC_T& allocator=ALLOC_T())
+			: base(n,functor,storage,allocator) {}
+	// Serves a tree written by save() straight out of the mapped file (runs in
+	// O(1) time, or O(n) time to verify the checksum; see gutter_file.h)
+	static gutter_mapped<gutter_retrieve> open_mmap(const char* path, bool verify=false) {
+		return gutter_mapped<gutter_retrieve>(path, verify);
+	}
+	// Deep copy (runs in O(n) time)
+	gutter_retrieve clone() const {
+		return gutter_retrieve(*this, typename base::clone_tag());
+	}
+	void swap(gutter_retrieve& other) {
+		base::swap(other);
 	}
 	// Access Method (run in O(1) time)
 	RESULT_T operator[](INDEX_T leaf_no) const {
-		return this->heap[this->index_nth_leaf(leaf_no)];
+		return this->node(this->index_nth_leaf(leaf_no));
 	}
 	// Access Methods (run in O(log(n)) time)
 	void assign(INDEX_T leaf_no, RESULT_T& x) {
 		leaf_no = this->index_nth_leaf(leaf_no);
-		this->heap[leaf_no] = x;
+		this->node(leaf_no) = x;
 		base::template act_on_all_ancestors_leafup(
 				this->index_parent(leaf_no),
-				functor_update_parent(this->heap, this->op)
+				functor_update_parent(*this)
 			);
 	}
 	void apply(INDEX_T leaf_no, RESULT_T& x) {
 		leaf_no = this->index_nth_leaf(leaf_no);
-		this->heap[leaf_no] = this->op(this->heap[leaf_no], x);
+		this->node(leaf_no) = this->op(this->node(leaf_no), x);
 		base::template act_on_all_ancestors_leafup(
 				this->index_parent(leaf_no),
-				functor_update_parent(this->heap, this->op)
+				functor_update_parent(*this)
+			);
+	}
+	// Access Methods (run in O(k*log(k)+k*log(n/k)) time)
+	// - leaves are all written first, then each affected ancestor is
+	//	 recomputed exactly once
+	void assign_batch(const std::pair<INDEX_T,RESULT_T>* updates, INDEX_T k) {
+		std::vector<INDEX_T> parents(k);
+		for (INDEX_T j=0; j<k; ++j) {
+			const INDEX_T leaf_no = this->index_nth_leaf(updates[j].first);
+			this->node(leaf_no) = updates[j].second;
+			parents[j] = this->index_parent(leaf_no);
+		}
+		base::template act_on_shared_ancestors_leafup(
+				parents, functor_update_parent(*this)
+			);
+	}
+	void apply_batch(const std::pair<INDEX_T,RESULT_T>* updates, INDEX_T k) {
+		std::vector<INDEX_T> parents(k);
+		for (INDEX_T j=0; j<k; ++j) {
+			const INDEX_T leaf_no = this->index_nth_leaf(updates[j].first);
+			this->node(leaf_no) = this->op(this->node(leaf_no), updates[j].second);
+			parents[j] = this->index_parent(leaf_no);
+		}
+		base::template act_on_shared_ancestors_leafup(
+				parents, functor_update_parent(*this)
 			);
 	}
+	// = accumulate(0,n), read off the root (run in O(1) time)
+	// - the leaves are in order from left to right below every node, so the
+	//	 root combines all elements in order
+	RESULT_T total() const {
+		if (this->_size == 0) return this->op();
+		return this->node(1);
+	}
+	// Search Methods (run in O(log(n)) time)
+	// - 'pred' must be monotone over growing ranges (i.e., once true for some
+	//	 range starting at 'i1', it stays true as the range grows), e.g., a
+	//	 threshold on a sum of non-negative elements, or on a max
+	// = the smallest 'i' >= 'i1' such that pred(accumulate(i1,i+1)), or 'n'
+	template <typename PRED_T>
+	INDEX_T find_first(INDEX_T i1, PRED_T pred) const {
+		if (i1 >= this->_size) return this->_size;
+		RESULT_T res = this->op(), next = this->op();
+		INDEX_T index = this->index_nth_leaf(i1);
+		// Finds the first node starting at or after the current subtree for
+		// which the predicate holds, climbing while the subtrees are right
+		// branches
+		while (true) {
+			next = res;	// reuses the storage of 'next'
+			gutter_combine<FUNCTOR_T>::into(this->op, next, this->node(index));
+			if (pred(next))
+				break;
+			std::swap(res, next);
+			while (!this->index_islbranch(index))
+				index = this->index_parent(index);
+			if (index == 0)	// past the root: no more elements
+				return this->_size;
+			++index;
+		}
+		return descend_to_first(index, std::move(res), pred);
+	}
+	// = the smallest 'i' such that !(accumulate(0,i+1) < target), or 'n'
+	//	 (e.g., the element holding the 'target'th unit of a sum, counting from 1)
+	INDEX_T lower_bound_prefix(const RESULT_T& target) const {
+		if (this->_size == 0 || this->node(1) < target) return this->_size;
+		return descend_to_first(1, this->op(), functor_not_less(target));
+	}
+	// - commutative functors over trivially copyable results use a branch-free
+	//	 walk (see accumulate_span); other results (e.g., holding heap storage)
+	//	 are combined in place, without copying any node
 	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
-		return base::template act_on_min_covering_ancestors(
-				leaf1,leaf2, typename base::functor_get(*this)
-			).result();
+		return accumulate(leaf1, leaf2, std::integral_constant<bool,
+				gutter_is_commutative<FUNCTOR_T>::value
+				&& std::is_trivially_copyable<RESULT_T>::value>());
+	}
+	// Access Method (runs in O(k*log(n)) time)
+	// - interleaves the walks of up to 'lanes' ranges at a time, so that the
+	//	 cache misses of each walk overlap with the work of the others (see
+	//	 gutter_batch.h, for queueing ranges as they come)
+	// - a range equal to its predecessor reuses the predecessor's result
+	enum { batch_lanes = 8 };
+	void accumulate_batch(const std::pair<INDEX_T,INDEX_T>* ranges, std::size_t k,
+			RESULT_T* out, unsigned lanes=batch_lanes) const {
+		base::template act_interleaved<typename base::walk_min_covering_ancestors>(
+				ranges, k, out, lanes);
 	}
 	// Access Method (runs in O(k+log(n)-log(k)) time)
 	template <typename ITER_T>
@@ -78,6 +404,8 @@ public:
 		if (i1>i2) //error?
 			return input;
 		else if (i1==i2) return input;
+		// The leaves and their ancestors are counted as one walk
+		const gutter_stats_scope<STATS_T> scope(this->instrument);
 		// Get Leaf positions
 		i1 = this->index_nth_leaf(i1);
 		i2 = this->index_nth_leaf(i2-1);	// make i2 an inclusive bound
@@ -88,16 +416,67 @@ public:
 		// Update affected ancestors
 		i1 = this->index_parent(i1);
 		i2 = this->index_parent(i2);
-		base::template act_on_all_ancestors_leafup(
-				i1,i2, functor_update_parent(this->heap, this->op)
+		base::template act_on_all_ancestors_leafup_rows(
+				i1,i2, functor_update_parent(*this)
 			);
 		// Return iterator to end of copy location
 		return input;
 	}
-	// Constructor
+	// Access Method (runs in O(k/T+log(n)*grain) time)
+	enum { parallel_grain = 1<<16 };
+	template <typename ITER_T>
+	ITER_T assign(INDEX_T i1, INDEX_T i2, ITER_T input,
+			gutter_thread_pool& pool, INDEX_T grain=parallel_grain) {
+		if (i1>=i2) //error?
+			return input;
+		else if (i2-i1 < 2*grain) return assign(i1, i2, input);
+		const gutter_stats_scope<STATS_T> scope(this->instrument);
+		set_leaves(i1, i2, input, pool, grain);
+		base::template act_on_all_ancestors_leafup_rows(
+				this->index_parent(this->index_nth_leaf(i1)),
+				this->index_parent(this->index_nth_leaf(i2-1)),
+				functor_update_parent_parallel(*this, pool, grain)
+			);
+		return std::next(input, i2-i1);
+	}
+	// Access Method (runs in O(n) time)
+	template <typename ITER_T>
+	void rebuild(ITER_T first, ITER_T last) {
+		if (INDEX_T(std::distance(first,last)) != this->_size) //error?
+			return;
+		build(first);
+	}
+	// Access Method (runs in O(n/T+n/grain) time)
+	template <typename ITER_T>
+	void rebuild(ITER_T first, ITER_T last,
+			gutter_thread_pool& pool, INDEX_T grain=parallel_grain) {
+		if (INDEX_T(std::distance(first,last)) != this->_size) //error?
+			return;
+		build(first, pool, grain);
+	}
+	// Constructors (run in O(n) time)
 	gutter_retrieve(std::initializer_list<RESULT_T> source,
-			FUNCTOR_T functor=FUNCTOR_T()) : base(source.size(),functor) {
-		assign(0,source.size(), source.begin());
+			FUNCTOR_T functor=FUNCTOR_T(), const ALLOC_T& allocator=ALLOC_T())
+			: base(source.size(),functor,allocator) {
+		build(source.begin());
+	}
+	template <typename ITER_T, typename=gutter_iterator_category<ITER_T> >
+	gutter_retrieve(ITER_T first, ITER_T last, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: base(std::distance(first,last),functor,allocator) {
+		build(first);
+	}
+	template <typename ITER_T, typename=gutter_iterator_category<ITER_T> >
+	gutter_retrieve(ITER_T first, ITER_T last, gutter_thread_pool& pool,
+			FUNCTOR_T functor=FUNCTOR_T(), const ALLOC_T& allocator=ALLOC_T(),
+			INDEX_T grain=parallel_grain)
+			: base(std::distance(first,last),functor,allocator) {
+		build(first, pool, grain);
+	}
+	gutter_retrieve(std::vector<RESULT_T>&& source, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: base(source.size(),functor,allocator) {
+		build(std::make_move_iterator(source.begin()));
 	}
 };
 
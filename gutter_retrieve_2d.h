@@ -0,0 +1,201 @@
+#ifndef GUTTER_RETRIEVE_2D_H
+#define GUTTER_RETRIEVE_2D_H
+
+#include "gutter_base.h"
+#include <iterator>
+#include <memory>
+#include <vector>
+
+/*
+ * This class stores a 2-dimensional array of 'n1' rows by 'n2' columns of
+ * elements (e.g., time buckets by key), and returns a commutative associative
+ * operation (e.g., sum, min/max) over a rectangle of elements (i.e.,
+ * [i1,i2)x[j1,j2)) quickly.
+ *
+ * The heap-style index scheme of gutter_base is nested in both dimensions:
+ * node (a,b) holds the operation over the elements of the rows below row node
+ * 'a' and the columns below column node 'b'. All (2'n1'-1)x(2'n2'-1) nodes are
+ * stored in one contiguous allocation, row node by row node.
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the associative operation over a rectangle of elements
+ *		-> O(log(n1)*log(n2))
+ *	- computing the ('i','j')th element
+ *		-> O(1)
+ *	- setting/applying a new value to the ('i','j')th element
+ *		-> O(log(n1)*log(n2))
+ *	- constructing/rebuilding from a sequence of 'n1'*'n2' elements
+ *		-> O(n1*n2)
+ */
+template <typename RESULT_T, typename FUNCTOR_T, typename ALLOC_T=std::allocator<RESULT_T> >
+class gutter_retrieve_2d {
+	static_assert(gutter_is_commutative<FUNCTOR_T>::value,
+			"gutter_retrieve_2d requires a commutative functor");
+
+	typedef std::size_t INDEX_T;
+
+	INDEX_T rows, cols;
+	INDEX_T stride;	// = the number of column nodes per row node, 2'n2'-1
+	FUNCTOR_T op;
+	std::vector<RESULT_T, ALLOC_T> nodes;
+
+	static inline INDEX_T index_nth_leaf(INDEX_T n, INDEX_T size) {
+		return gutter_index::index_nth_leaf(n, size);
+	}
+	inline RESULT_T& node(INDEX_T a, INDEX_T b) {
+		return nodes[(a-1)*stride + (b-1)];
+	}
+	inline const RESULT_T& node(INDEX_T a, INDEX_T b) const {
+		return nodes[(a-1)*stride + (b-1)];
+	}
+	// = the row of column nodes of row node 'a'
+	inline RESULT_T* row(INDEX_T a) {
+		return &nodes[(a-1)*stride];
+	}
+
+	// Calls act(i1..) on the nodes covering the heap indices [i1,i2) of the
+	// bottom rows of one dimension (see gutter_retrieve::accumulate_span)
+	template <typename F>
+	static inline void act_on_span(INDEX_T i1, INDEX_T i2, F& act) {
+		for (; i1 < i2; i1 /= 2, i2 /= 2) {
+			if (i1 & 1)
+				act(i1++);
+			if (i2 & 1)
+				act(--i2);
+		}
+	}
+	// Calls act() on the nodes covering the elements [l1,l2) of a dimension
+	// of 'size' elements
+	template <typename F>
+	static inline void act_on_range(INDEX_T l1, INDEX_T l2, INDEX_T size, F& act) {
+		if (l1>=l2) return;
+		const INDEX_T i1 = index_nth_leaf(l1, size);
+		const INDEX_T i2 = index_nth_leaf(l2-1, size)+1;	// exclusive bound
+		if (i1 < i2) {
+			act_on_span(i1, i2, act);
+			return;
+		}
+		// Range wraps from the deepest row around to the row above it
+		act_on_span(i1, 2*size, act);
+		act_on_span(size, i2, act);
+	}
+
+	// Combines the column nodes covering [j1,j2) of one row node
+	class functor_get_cols {
+	private:
+		const gutter_retrieve_2d& tree;
+		const INDEX_T a;
+		RESULT_T res;
+	public:
+		functor_get_cols(const gutter_retrieve_2d& t, INDEX_T row_node)
+			: tree(t), a(row_node), res(t.op()) {}
+		void operator()(INDEX_T b) {
+			res = tree.op(res, tree.node(a, b));
+		}
+		const RESULT_T& result() const {return res;}
+	};
+	// Combines the row nodes covering [i1,i2), over the columns [j1,j2)
+	class functor_get_rows {
+	private:
+		const gutter_retrieve_2d& tree;
+		const INDEX_T j1, j2;
+		RESULT_T res;
+	public:
+		functor_get_rows(const gutter_retrieve_2d& t, INDEX_T c1, INDEX_T c2)
+			: tree(t), j1(c1), j2(c2), res(t.op()) {}
+		void operator()(INDEX_T a) {
+			functor_get_cols cols(tree, a);
+			act_on_range(j1, j2, tree.cols, cols);
+			res = tree.op(res, cols.result());
+		}
+		const RESULT_T& result() const {return res;}
+	};
+
+	// Recomputes the column nodes of row node 'a' from its two children
+	void update_row_node(INDEX_T a) {
+		RESULT_T* const dst = row(a);
+		const RESULT_T* const l = row(2*a);
+		const RESULT_T* const r = row(2*a+1);
+		for (INDEX_T b=0; b<stride; ++b)
+			dst[b] = op(l[b], r[b]);
+	}
+	template <typename ITER_T>
+	ITER_T build(ITER_T input) {
+		for (INDEX_T i=0; i<rows; ++i) {
+			const INDEX_T a = index_nth_leaf(i, rows);
+			for (INDEX_T j=0; j<cols; ++j, ++input)
+				node(a, index_nth_leaf(j, cols)) = *input;
+			for (INDEX_T b=cols-1; b>0; --b)
+				node(a, b) = op(node(a, 2*b), node(a, 2*b+1));
+		}
+		// Children always have greater indices than their parents
+		for (INDEX_T a=rows-1; a>0; --a)
+			update_row_node(a);
+		return input;
+	}
+
+public:
+	typedef RESULT_T result_type;
+	typedef FUNCTOR_T functor_type;
+
+	// Constructor
+	gutter_retrieve_2d(INDEX_T n1, INDEX_T n2, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: rows(n1), cols(n2), stride(2*n2-1), op(functor),
+			nodes((2*n1-1)*(2*n2-1), functor(), allocator) {}
+	// Constructor (runs in O(n1*n2) time)
+	// - from 'n1'*'n2' elements in row-major order
+	template <typename ITER_T>
+	gutter_retrieve_2d(INDEX_T n1, INDEX_T n2, ITER_T input, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: rows(n1), cols(n2), stride(2*n2-1), op(functor),
+			nodes((2*n1-1)*(2*n2-1), functor(), allocator) {
+		build(input);
+	}
+	INDEX_T row_count() const {
+		return rows;
+	}
+	INDEX_T column_count() const {
+		return cols;
+	}
+
+	// Access Method (runs in O(1) time)
+	RESULT_T operator()(INDEX_T i, INDEX_T j) const {
+		return node(index_nth_leaf(i, rows), index_nth_leaf(j, cols));
+	}
+	// Access Methods (run in O(log(n1)*log(n2)) time)
+	void assign(INDEX_T i, INDEX_T j, const RESULT_T& x) {
+		const INDEX_T a0 = index_nth_leaf(i, rows), b0 = index_nth_leaf(j, cols);
+		node(a0, b0) = x;
+		for (INDEX_T b=b0/2; b>0; b/=2)
+			node(a0, b) = op(node(a0, 2*b), node(a0, 2*b+1));
+		for (INDEX_T a=a0/2; a>0; a/=2) {
+			for (INDEX_T b=b0; b>0; b/=2)
+				node(a, b) = op(node(2*a, b), node(2*a+1, b));
+		}
+	}
+	void apply(INDEX_T i, INDEX_T j, const RESULT_T& x) {
+		const INDEX_T b0 = index_nth_leaf(j, cols);
+		for (INDEX_T a=index_nth_leaf(i, rows); a>0; a/=2) {
+			for (INDEX_T b=b0; b>0; b/=2)
+				node(a, b) = op(node(a, b), x);
+		}
+	}
+	// = the operation over the elements [i1,i2)x[j1,j2)
+	RESULT_T accumulate(INDEX_T i1, INDEX_T i2, INDEX_T j1, INDEX_T j2) const {
+		if (j1>=j2) return op();
+		functor_get_rows get(*this, j1, j2);
+		act_on_range(i1, i2, rows, get);
+		return get.result();
+	}
+	// Access Method (runs in O(n1*n2) time)
+	template <typename ITER_T>
+	void rebuild(ITER_T first, ITER_T last) {
+		if (INDEX_T(std::distance(first,last)) != rows*cols) //error?
+			return;
+		build(first);
+	}
+};
+
+
+#endif
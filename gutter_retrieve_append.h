@@ -0,0 +1,99 @@
+#ifndef GUTTER_RETRIEVE_APPEND_H
+#define GUTTER_RETRIEVE_APPEND_H
+
+#include "gutter_retrieve.h"
+#include <vector>
+
+/*
+ * This class provides the interface of gutter_retrieve over a sequence that
+ * grows at its end, one element at a time.
+ *
+ * The elements are stored in a forest of perfect gutter_retrieve trees
+ * ("chunks"), each twice the capacity of the one before: chunk 'k' holds the
+ * elements C*(2^k-1) to C*(2^(k+1)-1)-1, where 'C' is the capacity of the
+ * first chunk. Appending to a full forest allocates one new chunk, as large as
+ * all of the previous chunks together, and never moves the elements already
+ * stored; the unused leaves of the last chunk hold the identity element.
+ *
+ * A range query spans at most O(log(n)) chunks; the chunks strictly inside the
+ * range each contribute their total, read off their root in O(1) time.
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the associative operation over 'k' sequential elements
+ *		-> O(log(n))
+ *	- setting/applying a new value to the 'i'th element
+ *		-> O(log(n))
+ *	- appending a new element
+ *		-> O(log(n)), plus an amortized O(1) to allocate new chunks
+ */
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T=gutter_layout_bfs>
+class gutter_retrieve_append {
+	typedef std::size_t INDEX_T;
+	typedef gutter_retrieve<RESULT_T, FUNCTOR_T, LAYOUT_T> chunk_t;
+
+	INDEX_T _size;
+	INDEX_T first_capacity;	// a power of 2
+	FUNCTOR_T op;
+	std::vector<chunk_t> chunks;
+
+	inline INDEX_T chunk_of(INDEX_T i) const {
+		return gutter_log2(i/first_capacity + 1);
+	}
+	inline INDEX_T chunk_first(INDEX_T k) const {
+		return first_capacity * ((INDEX_T(1) << k) - 1);
+	}
+	inline INDEX_T chunk_capacity(INDEX_T k) const {
+		return first_capacity << k;
+	}
+
+public:
+	// Constructor
+	// - 'capacity' is that of the first chunk, rounded up to a power of 2
+	gutter_retrieve_append(FUNCTOR_T functor=FUNCTOR_T(), INDEX_T capacity=64)
+			: _size(0), first_capacity(1), op(functor) {
+		while (first_capacity < capacity)
+			first_capacity *= 2;
+	}
+	INDEX_T size() const {
+		return _size;
+	}
+	INDEX_T capacity() const {
+		return chunk_first(chunks.size());
+	}
+
+	// Access Method (runs in O(log(n)) time)
+	void push_back(const RESULT_T& x) {
+		if (_size == capacity())
+			chunks.emplace_back(chunk_capacity(chunks.size()), op);
+		RESULT_T value = x;
+		chunks.back().assign(_size - chunk_first(chunks.size()-1), value);
+		++_size;
+	}
+	// Access Method (run in O(1) time)
+	RESULT_T operator[](INDEX_T leaf_no) const {
+		const INDEX_T k = chunk_of(leaf_no);
+		return chunks[k][leaf_no - chunk_first(k)];
+	}
+	// Access Methods (run in O(log(n)) time)
+	void assign(INDEX_T leaf_no, RESULT_T& x) {
+		const INDEX_T k = chunk_of(leaf_no);
+		chunks[k].assign(leaf_no - chunk_first(k), x);
+	}
+	void apply(INDEX_T leaf_no, RESULT_T& x) {
+		const INDEX_T k = chunk_of(leaf_no);
+		chunks[k].apply(leaf_no - chunk_first(k), x);
+	}
+	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
+		if (leaf1>=leaf2) return op();
+		const INDEX_T k1 = chunk_of(leaf1), k2 = chunk_of(leaf2-1);
+		if (k1 == k2)
+			return chunks[k1].accumulate(leaf1 - chunk_first(k1), leaf2 - chunk_first(k1));
+		RESULT_T res = chunks[k1].accumulate(leaf1 - chunk_first(k1), chunk_capacity(k1));
+		for (INDEX_T k=k1+1; k<k2; ++k)
+			res = op(res, chunks[k].total());
+		return op(res, chunks[k2].accumulate(0, leaf2 - chunk_first(k2)));
+	}
+};
+
+
+#endif
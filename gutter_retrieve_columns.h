@@ -0,0 +1,226 @@
+#ifndef GUTTER_RETRIEVE_COLUMNS_H
+#define GUTTER_RETRIEVE_COLUMNS_H
+
+#include "gutter_index.h"
+#include "gutter_layout.h"
+#include "gutter_simd.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Compile-time lists of column numbers 0, ..., N-1
+template <std::size_t... COLUMNS>
+struct gutter_columns_indices {};
+template <std::size_t N, std::size_t... COLUMNS>
+struct gutter_columns_make_indices : gutter_columns_make_indices<N-1, N-1, COLUMNS...> {};
+template <std::size_t... COLUMNS>
+struct gutter_columns_make_indices<0, COLUMNS...> {
+	typedef gutter_columns_indices<COLUMNS...> type;
+};
+
+/*
+ * This class provides the interface of gutter_retrieve for several columns of
+ * elements over the same range of keys (e.g., a count, a sum, a min and a max),
+ * each column with its own type and functor, given as tuples:
+ *	gutter_retrieve_columns<std::tuple<long,int,int>,
+ *			std::tuple<add<long>,min<int>,max<int> > >
+ * Elements, and results, are read and written as tuples of one value per
+ * column.
+ *
+ * Each column is stored as a heap of its own (struct-of-arrays), all of them in
+ * the same layout; an operation walks the tree once, acting on every column at
+ * each node. Queries compute the set of minimal covering ancestors once, then
+ * reduce every column over it; rows of ancestors are recomputed one column at
+ * a time (vectorized for add/min/max over arithmetic types, see gutter_simd.h).
+ *
+ * OPERATIONS & COMPLEXITY (for 'c' columns)
+ * 	- computing the associative operations over 'k' sequential elements
+ *		-> O(c*log(n)), in one walk
+ *	- setting/applying new values to the 'i'th element
+ *		-> O(c*log(n)), in one walk
+ *	- setting a collection of 'k' sequential elements
+ *		-> O(c*(k+log(n)-log(k)))
+ *	- constructing from a sequence of 'n' elements
+ *		-> O(c*n)
+ */
+template <typename RESULT_TUPLE_T, typename FUNCTOR_TUPLE_T,
+		typename LAYOUT_T=gutter_layout_bfs>
+class gutter_retrieve_columns;
+
+template <typename... RESULT_Ts, typename... FUNCTOR_Ts, typename LAYOUT_T>
+class gutter_retrieve_columns<std::tuple<RESULT_Ts...>, std::tuple<FUNCTOR_Ts...>, LAYOUT_T> {
+	static_assert(sizeof...(RESULT_Ts) == sizeof...(FUNCTOR_Ts),
+			"gutter_retrieve_columns needs one functor per column");
+	static_assert(sizeof...(RESULT_Ts) > 0, "gutter_retrieve_columns needs a column");
+
+	typedef std::size_t INDEX_T;
+	typedef typename gutter_columns_make_indices<sizeof...(RESULT_Ts)>::type columns;
+
+public:
+	typedef std::tuple<RESULT_Ts...> result_type;
+	typedef std::tuple<FUNCTOR_Ts...> functor_type;
+	typedef LAYOUT_T layout_type;
+
+private:
+	INDEX_T _size;
+	LAYOUT_T layout;
+	functor_type op;
+	std::tuple<std::vector<RESULT_Ts>...> heaps;
+
+	inline INDEX_T index_nth_leaf(INDEX_T n) const {
+		return gutter_index::index_nth_leaf(n, _size);
+	}
+
+	template <std::size_t... COLUMNS>
+	void fill_identity(gutter_columns_indices<COLUMNS...>) {
+		const int expand[] = {0, (std::get<COLUMNS>(heaps).assign(
+				layout.storage_size(), std::get<COLUMNS>(op)()), 0)...};
+		(void)expand;
+	}
+	template <std::size_t... COLUMNS>
+	void set_node(INDEX_T index, const result_type& x, gutter_columns_indices<COLUMNS...>) {
+		const INDEX_T p = layout.position(index);
+		const int expand[] = {0, (std::get<COLUMNS>(heaps)[p] = std::get<COLUMNS>(x), 0)...};
+		(void)expand;
+	}
+	template <std::size_t... COLUMNS>
+	void apply_node(INDEX_T index, const result_type& x, gutter_columns_indices<COLUMNS...>) {
+		const INDEX_T p = layout.position(index);
+		const int expand[] = {0, (std::get<COLUMNS>(heaps)[p] = std::get<COLUMNS>(op)(
+				std::get<COLUMNS>(heaps)[p], std::get<COLUMNS>(x)), 0)...};
+		(void)expand;
+	}
+	template <std::size_t... COLUMNS>
+	result_type get_node(INDEX_T index, gutter_columns_indices<COLUMNS...>) const {
+		const INDEX_T p = layout.position(index);
+		return result_type(std::get<COLUMNS>(heaps)[p]...);
+	}
+	// Recomputes a node from its children, in every column
+	template <std::size_t... COLUMNS>
+	void update_node(INDEX_T index, gutter_columns_indices<COLUMNS...>) {
+		const INDEX_T p = layout.position(index);
+		const INDEX_T l = layout.position(gutter_index::index_lbranch(index));
+		const INDEX_T r = layout.position(gutter_index::index_rbranch(index));
+		const int expand[] = {0, (std::get<COLUMNS>(heaps)[p] = std::get<COLUMNS>(op)(
+				std::get<COLUMNS>(heaps)[l], std::get<COLUMNS>(heaps)[r]), 0)...};
+		(void)expand;
+	}
+	// Recomputes the run of nodes [j1,j2] within a row, one column at a time
+	template <std::size_t... COLUMNS>
+	void update_row(INDEX_T j1, INDEX_T j2, gutter_columns_indices<COLUMNS...>, std::true_type) {
+		// Children of a contiguous run of nodes are also a contiguous run
+		const INDEX_T p = layout.position(j1);
+		const INDEX_T c = layout.position(gutter_index::index_lbranch(j1));
+		const int expand[] = {0, (gutter_simd_reduce_pairs(std::get<COLUMNS>(op),
+				&std::get<COLUMNS>(heaps)[p], &std::get<COLUMNS>(heaps)[c], j2-j1+1), 0)...};
+		(void)expand;
+	}
+	void update_row(INDEX_T j1, INDEX_T j2, columns, std::false_type) {
+		for (; j1<=j2; ++j1)
+			update_node(j1, columns());
+	}
+	inline void update_row(INDEX_T j1, INDEX_T j2) {
+		update_row(j1, j2, columns(), std::integral_constant<bool, LAYOUT_T::contiguous_rows>());
+	}
+	inline void update_ancestors(INDEX_T index) {
+		for (index = gutter_index::index_parent(index); index > 0;
+				index = gutter_index::index_parent(index))
+			update_node(index, columns());
+	}
+	// Reduces every column over the given nodes, in order
+	template <std::size_t... COLUMNS>
+	result_type reduce(const INDEX_T* path, unsigned length,
+			gutter_columns_indices<COLUMNS...>) const {
+		result_type res(std::get<COLUMNS>(op)()...);
+		for (unsigned k=0; k<length; ++k) {
+			const INDEX_T p = layout.position(path[k]);
+			const int expand[] = {0, (std::get<COLUMNS>(res) = std::get<COLUMNS>(op)(
+					std::get<COLUMNS>(res), std::get<COLUMNS>(heaps)[p]), 0)...};
+			(void)expand;
+		}
+		return res;
+	}
+
+	template <typename ITER_T>
+	ITER_T build(ITER_T input) {
+		for (INDEX_T i=0; i<_size; ++i, ++input)
+			set_node(index_nth_leaf(i), *input, columns());
+		if (_size > 1) {
+			for (INDEX_T i=gutter_index::index_first_of_row(_size-1); i>0; i/=2)
+				update_row(i, std::min(2*i-1, _size-1));
+		}
+		return input;
+	}
+
+public:
+	// Constructor
+	gutter_retrieve_columns(INDEX_T n, functor_type functors=functor_type())
+			: _size(n), layout(n), op(functors) {
+		fill_identity(columns());
+	}
+	// Constructor (runs in O(c*n) time)
+	// - from a sequence of tuples, one per element
+	template <typename ITER_T, typename=gutter_iterator_category<ITER_T> >
+	gutter_retrieve_columns(ITER_T first, ITER_T last, functor_type functors=functor_type())
+			: _size(std::distance(first,last)), layout(_size), op(functors) {
+		fill_identity(columns());
+		build(first);
+	}
+	INDEX_T size() const {
+		return _size;
+	}
+
+	// Access Method (runs in O(c) time)
+	result_type operator[](INDEX_T leaf_no) const {
+		return get_node(index_nth_leaf(leaf_no), columns());
+	}
+	// = accumulate(0,n), read off the root
+	result_type total() const {
+		return get_node(1, columns());
+	}
+	// Access Methods (run in O(c*log(n)) time)
+	void assign(INDEX_T leaf_no, const result_type& x) {
+		const INDEX_T index = index_nth_leaf(leaf_no);
+		set_node(index, x, columns());
+		update_ancestors(index);
+	}
+	void apply(INDEX_T leaf_no, const result_type& x) {
+		const INDEX_T index = index_nth_leaf(leaf_no);
+		apply_node(index, x, columns());
+		update_ancestors(index);
+	}
+	result_type accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
+		// The minimal covering ancestors, in leaf order
+		INDEX_T path[gutter_index::max_covering];
+		const unsigned length = gutter_index::index_min_covering_ancestors(
+				leaf1, leaf2, _size, path);
+		return reduce(path, length, columns());
+	}
+	// Access Method (runs in O(c*(k+log(n)-log(k))) time)
+	// - from a sequence of tuples, one per element
+	template <typename ITER_T>
+	ITER_T assign(INDEX_T i1, INDEX_T i2, ITER_T input) {
+		if (i1>=i2) //error?
+			return input;
+		for (INDEX_T i=i1; i<i2; ++i, ++input)
+			set_node(index_nth_leaf(i), *input, columns());
+		// Update affected ancestors, one row at a time
+		INDEX_T j1 = gutter_index::index_parent(index_nth_leaf(i1));
+		INDEX_T j2 = gutter_index::index_parent(index_nth_leaf(i2-1));
+		if (j1>j2) {
+			// Range wraps from the deepest row around to the row above it
+			update_row(j1, gutter_index::index_ancestor_in_row(2*_size-1,
+					gutter_index::index_first_of_row(j1)));
+			j1 /= 2;
+		}
+		for (; j1 > 0; j1 /= 2, j2 /= 2)
+			update_row(j1, j2);
+		return input;
+	}
+};
+
+
+#endif
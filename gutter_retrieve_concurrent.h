@@ -0,0 +1,231 @@
+#ifndef GUTTER_RETRIEVE_CONCURRENT_H
+#define GUTTER_RETRIEVE_CONCURRENT_H
+
+#include "gutter_base.h"
+#include <atomic>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+/*
+ * This class provides the interface of gutter_retrieve to any number of
+ * concurrent reader threads, alongside a single writer thread.
+ *
+ * Each node is stored as a std::atomic<RESULT_T>, so that no node is ever
+ * read half-written, and carries a version, incremented after each store into
+ * the node; the writer updates a leaf and then its ancestors, leaf-up, one
+ * store per node. A reader combining several nodes (i.e., the minimal covering
+ * ancestors of its range, in leaf order) reads the version and value of each,
+ * then reads the versions again, and accepts the values only if no version
+ * changed (i.e., no store landed on the walked nodes in between), retrying
+ * otherwise. Writes elsewhere in the tree never cause a retry, and there is no
+ * counter shared by all writes; readers never write to shared memory, nor
+ * block the writer or each other. A read is lock-free but not wait-free: it
+ * may retry for as long as writes keep landing on its nodes (e.g., on wide
+ * ranges, whose covering ancestors are near the root). accumulate_relaxed()
+ * skips this validation and never retries (i.e., is wait-free), combining
+ * each node as of some point during the walk. Nodes are combined in leaf
+ * order, so 'FUNCTOR_T' need not be commutative.
+ *
+ * Each point assign/apply is seen by a reader either entirely or not at all; a
+ * range assign may be seen in part, as if its elements were assigned one at a
+ * time.
+ *
+ * The writer methods must not be called from more than one thread at a time;
+ * 'RESULT_T' must be trivially copyable (see std::atomic).
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the associative operation over 'k' sequential elements
+ *		-> O(log(n)), plus one retry per write landing on the walked nodes
+ *		   during the read
+ *	- getting the 'i'th element
+ *		-> O(1), without retries
+ *	- setting/applying a new value to the 'i'th element
+ *		-> O(log(n))
+ *	- setting a collection of 'k' sequential elements
+ *		-> O(k+log(n))
+ *	- constructing from a sequence of 'n' elements
+ *		-> O(n)
+ */
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T=gutter_layout_bfs>
+class gutter_retrieve_concurrent
+		: public gutter_base<std::atomic<RESULT_T>, FUNCTOR_T, LAYOUT_T> {
+	static_assert(std::is_trivially_copyable<RESULT_T>::value,
+			"gutter_retrieve_concurrent requires a trivially copyable RESULT_T");
+
+	typedef gutter_base<std::atomic<RESULT_T>, FUNCTOR_T, LAYOUT_T> base;
+	typedef typename base::INDEX_T INDEX_T;
+
+	// The number of stores into each node so far, by storage position
+	std::unique_ptr<std::atomic<std::size_t>[]> versions;
+
+	inline std::atomic<std::size_t>& version(INDEX_T index) const {
+		return versions[this->layout.position(index)];
+	}
+	inline RESULT_T load(INDEX_T index) const {
+		return this->node(index).load(std::memory_order_relaxed);
+	}
+	// - the release store orders the version increments of the nodes stored
+	//	 before, for readers validating them after reading this node
+	inline void store(INDEX_T index, const RESULT_T& x) {
+		this->node(index).store(x, std::memory_order_release);
+		version(index).fetch_add(1, std::memory_order_release);
+	}
+	void init_versions() {
+		for (INDEX_T i=0; i<this->layout.storage_size(); ++i)
+			versions[i].store(0, std::memory_order_relaxed);
+	}
+
+	class functor_update_parent {
+	private:
+		gutter_retrieve_concurrent& tree;
+	public:
+		functor_update_parent(gutter_retrieve_concurrent& t) : tree(t) {}
+		void operator()(INDEX_T index) {
+			tree.store(index, tree.op(
+					tree.load(base::index_lbranch(index)),
+					tree.load(base::index_rbranch(index))
+				));
+		}
+		// Updates the run of nodes [j1,j2] within a row
+		void operator()(INDEX_T j1, INDEX_T j2) {
+			for (; j1<=j2; ++j1)
+				(*this)(j1);
+		}
+	};
+	template <typename ITER_T>
+	class functor_set_from_iter {
+	private:
+		gutter_retrieve_concurrent& tree;
+		ITER_T iter;
+	public:
+		functor_set_from_iter(gutter_retrieve_concurrent& t, ITER_T it)
+			: tree(t), iter(it) {}
+		void operator()(INDEX_T index) {
+			tree.store(index, *(iter++));
+		}
+		ITER_T iterator() {
+			return iter;
+		}
+	};
+
+	template <typename ITER_T>
+	ITER_T build(ITER_T input) {
+		input = base::template act_on_leaves_in_order(
+				this->index_nth_leaf(0), this->index_nth_leaf(this->_size-1),
+				functor_set_from_iter<ITER_T>(*this,input)
+			).iterator();
+		functor_update_parent update(*this);
+		for (INDEX_T i=this->_size-1; i>0; --i)
+			update(i);
+		return input;
+	}
+
+	inline void update_ancestors(INDEX_T leaf) {
+		base::template act_on_all_ancestors_leafup(
+				this->index_parent(leaf), functor_update_parent(*this));
+	}
+
+public:
+	// Constructor
+	gutter_retrieve_concurrent(INDEX_T n, FUNCTOR_T functor=FUNCTOR_T())
+			: base(n,functor),
+			versions(new std::atomic<std::size_t>[this->layout.storage_size()]) {
+		init_versions();
+		for (INDEX_T i=0; i<this->layout.storage_size(); ++i)
+			this->heap[i].store(this->op(), std::memory_order_relaxed);
+	}
+	// Constructors (run in O(n) time)
+	gutter_retrieve_concurrent(std::initializer_list<RESULT_T> source,
+			FUNCTOR_T functor=FUNCTOR_T())
+			: base(source.size(),functor),
+			versions(new std::atomic<std::size_t>[this->layout.storage_size()]) {
+		init_versions();
+		build(source.begin());
+	}
+	template <typename ITER_T, typename=gutter_iterator_category<ITER_T> >
+	gutter_retrieve_concurrent(ITER_T first, ITER_T last, FUNCTOR_T functor=FUNCTOR_T())
+			: base(std::distance(first,last),functor),
+			versions(new std::atomic<std::size_t>[this->layout.storage_size()]) {
+		init_versions();
+		build(first);
+	}
+
+	// Reader Methods (safe to call from any thread)
+	// - a single leaf is never torn, so needs no validation (runs in O(1) time)
+	RESULT_T operator[](INDEX_T leaf_no) const {
+		return this->node(this->index_nth_leaf(leaf_no)).load(std::memory_order_acquire);
+	}
+	// - linearizable with respect to the writer methods (runs in O(log(n)) time
+	//	 per attempt, retrying only while writes land on the walked nodes)
+	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
+		INDEX_T path[gutter_index::max_covering];
+		std::size_t seen[gutter_index::max_covering];
+		const unsigned length = gutter_index::index_min_covering_ancestors(
+				leaf1, leaf2, this->_size, path);
+		while (true) {
+			RESULT_T res = this->op();
+			for (unsigned k=0; k<length; ++k) {
+				seen[k] = version(path[k]).load(std::memory_order_acquire);
+				res = this->op(res, load(path[k]));
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			// No store into the walked nodes was published during the walk
+			bool unchanged = true;
+			for (unsigned k=0; k<length && unchanged; ++k)
+				unchanged = (version(path[k]).load(std::memory_order_relaxed) == seen[k]);
+			if (unchanged)
+				return res;
+		}
+	}
+	// - never retries (runs in O(log(n)) time)
+	RESULT_T accumulate_relaxed(INDEX_T leaf1, INDEX_T leaf2) const {
+		INDEX_T path[gutter_index::max_covering];
+		const unsigned length = gutter_index::index_min_covering_ancestors(
+				leaf1, leaf2, this->_size, path);
+		RESULT_T res = this->op();
+		for (unsigned k=0; k<length; ++k)
+			res = this->op(res, this->node(path[k]).load(std::memory_order_acquire));
+		return res;
+	}
+
+	// Writer Methods (to be called by a single thread at a time)
+	// - run in O(log(n)) time
+	void assign(INDEX_T leaf_no, const RESULT_T& x) {
+		leaf_no = this->index_nth_leaf(leaf_no);
+		store(leaf_no, x);
+		update_ancestors(leaf_no);
+	}
+	void apply(INDEX_T leaf_no, const RESULT_T& x) {
+		leaf_no = this->index_nth_leaf(leaf_no);
+		store(leaf_no, this->op(load(leaf_no), x));
+		update_ancestors(leaf_no);
+	}
+	// - runs in O(k+log(n)) time
+	template <typename ITER_T>
+	ITER_T assign(INDEX_T i1, INDEX_T i2, ITER_T input) {
+		if (i1>=i2) //error?
+			return input;
+		i1 = this->index_nth_leaf(i1);
+		i2 = this->index_nth_leaf(i2-1);	// make i2 an inclusive bound
+		input = base::template act_on_leaves_in_order(
+				i1,i2, functor_set_from_iter<ITER_T>(*this,input)
+			).iterator();
+		base::template act_on_all_ancestors_leafup_rows(
+				this->index_parent(i1), this->index_parent(i2),
+				functor_update_parent(*this)
+			);
+		return input;
+	}
+	// - runs in O(n) time
+	template <typename ITER_T>
+	void rebuild(ITER_T first, ITER_T last) {
+		if (INDEX_T(std::distance(first,last)) != this->_size) //error?
+			return;
+		build(first);
+	}
+};
+
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef GUTTER_RETRIEVE_FIXED_H
+#define GUTTER_RETRIEVE_FIXED_H
+
+#include "gutter_base.h"
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+
+// Marks the methods below that loop or write as constexpr where the language
+// allows it (C++14 onward); in C++11 they are only inline
+#ifndef GUTTER_CONSTEXPR
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201304
+#define GUTTER_CONSTEXPR constexpr
+#else
+#define GUTTER_CONSTEXPR inline
+#endif
+#endif
+
+// = the least power of 2 no less than 'n', and the log2 of a power of 2 'p'
+constexpr std::size_t gutter_fixed_round_up(std::size_t n, std::size_t p=1) {
+	return (p >= n) ? p : gutter_fixed_round_up(n, 2*p);
+}
+constexpr std::size_t gutter_fixed_log2(std::size_t p) {
+	return (p <= 1) ? 0 : 1+gutter_fixed_log2(p/2);
+}
+
+/*
+ * This class provides the interface of gutter_retrieve for a number of elements
+ * 'N' known at compile time, with the nodes stored inline (i.e., within the
+ * object itself, on the stack or inside an enclosing struct) rather than on the
+ * heap.
+ *
+ * The leaves are those of a perfect tree of 'N' rounded up to a power of 2 (the
+ * spare leaves holding the identity element), so that leaf 'i' is always node
+ * 'capacity'+'i': every index computation is a compile-time constant plus an
+ * offset, and every loop runs a fixed log2(capacity)+1 times, which the
+ * compiler is free to unroll.
+ *
+ * With a constexpr functor (e.g., add, mult, min, max), construction, updates and
+ * queries can all be evaluated at compile time (from C++14 onward).
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the associative operation over 'k' sequential elements
+ *		-> O(log(N))
+ *	- setting/applying a new value to the 'i'th element
+ *		-> O(log(N))
+ *	- constructing/rebuilding from a sequence of 'N' elements
+ *		-> O(N)
+ */
+template <typename RESULT_T, typename FUNCTOR_T, std::size_t N>
+class gutter_retrieve_fixed {
+	typedef std::size_t INDEX_T;
+
+public:
+	typedef RESULT_T result_type;
+	typedef FUNCTOR_T functor_type;
+
+	enum : INDEX_T {
+		capacity = gutter_fixed_round_up(N),	// = the number of leaves
+		levels = gutter_fixed_log2(capacity)	// = the depth of the leaves
+	};
+
+private:
+	FUNCTOR_T op;
+	// Heap-style: node 'i' has children 2'i' and 2'i'+1, and node 0 is unused
+	RESULT_T nodes[2*capacity];
+
+	static constexpr INDEX_T index_nth_leaf(INDEX_T n) {
+		return capacity + n;
+	}
+
+	GUTTER_CONSTEXPR void fill_identity() {
+		for (INDEX_T i=0; i<2*capacity; ++i)
+			nodes[i] = op();
+	}
+	GUTTER_CONSTEXPR void build() {
+		for (INDEX_T i=capacity-1; i>0; --i)
+			nodes[i] = op(nodes[2*i], nodes[2*i+1]);
+	}
+	template <typename ITER_T>
+	GUTTER_CONSTEXPR void build(ITER_T input, INDEX_T count) {
+		for (INDEX_T i=0; i<count; ++i, ++input)
+			nodes[index_nth_leaf(i)] = *input;
+		build();
+	}
+	GUTTER_CONSTEXPR void update_ancestors(INDEX_T index) {
+		for (index /= 2; index > 0; index /= 2)
+			nodes[index] = op(nodes[2*index], nodes[2*index+1]);
+	}
+
+public:
+	// Constructor (runs in O(N) time)
+	GUTTER_CONSTEXPR explicit gutter_retrieve_fixed(FUNCTOR_T functor=FUNCTOR_T())
+			: op(functor), nodes() {
+		fill_identity();
+	}
+	// Constructors (run in O(N) time)
+	// - elements past the first 'N' of the source are ignored
+	GUTTER_CONSTEXPR gutter_retrieve_fixed(std::initializer_list<RESULT_T> source,
+			FUNCTOR_T functor=FUNCTOR_T())
+			: op(functor), nodes() {
+		fill_identity();
+		build(source.begin(), source.size() < N ? source.size() : N);
+	}
+	template <typename ITER_T>
+	GUTTER_CONSTEXPR gutter_retrieve_fixed(ITER_T first, ITER_T last,
+			FUNCTOR_T functor=FUNCTOR_T())
+			: op(functor), nodes() {
+		fill_identity();
+		const INDEX_T count = std::distance(first,last);
+		build(first, count < N ? count : N);
+	}
+	static constexpr INDEX_T size() {
+		return N;
+	}
+
+	// Access Methods (run in O(1) time)
+	constexpr RESULT_T operator[](INDEX_T leaf_no) const {
+		return nodes[index_nth_leaf(leaf_no)];
+	}
+	// = the operation over all elements
+	constexpr RESULT_T total() const {
+		return nodes[1];
+	}
+	// Access Methods (run in O(log(N)) time)
+	GUTTER_CONSTEXPR void assign(INDEX_T leaf_no, const RESULT_T& x) {
+		const INDEX_T index = index_nth_leaf(leaf_no);
+		nodes[index] = x;
+		update_ancestors(index);
+	}
+	GUTTER_CONSTEXPR void apply(INDEX_T leaf_no, const RESULT_T& x) {
+		const INDEX_T index = index_nth_leaf(leaf_no);
+		nodes[index] = op(nodes[index], x);
+		update_ancestors(index);
+	}
+	GUTTER_CONSTEXPR RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
+		if (leaf1>=leaf2) return op();
+		// Bottom-up over [l,r), one row per iteration; the results of each side
+		// are kept apart, to be combined in order
+		RESULT_T lres = op(), rres = op();
+		INDEX_T l = index_nth_leaf(leaf1), r = index_nth_leaf(leaf2);
+		for (INDEX_T depth=0; depth<=levels; ++depth, l /= 2, r /= 2) {
+			if (l < r && (l & 1))
+				lres = op(lres, nodes[l++]);
+			if (l < r && (r & 1))
+				rres = op(nodes[--r], rres);
+		}
+		return op(lres, rres);
+	}
+	// Access Method (runs in O(N) time)
+	template <typename ITER_T>
+	GUTTER_CONSTEXPR void rebuild(ITER_T first, ITER_T last) {
+		if (INDEX_T(std::distance(first,last)) != N) //error?
+			return;
+		build(first, N);
+	}
+};
+
+
+#endif
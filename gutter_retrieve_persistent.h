@@ -0,0 +1,232 @@
+#ifndef GUTTER_RETRIEVE_PERSISTENT_H
+#define GUTTER_RETRIEVE_PERSISTENT_H
+
+#include "gutter_base.h"
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+/*
+ * This class provides the interface of gutter_retrieve, while keeping every
+ * earlier version of the elements queryable: each assign/apply creates a new
+ * version, numbered from 0 (the version as constructed) upward, and any
+ * version still kept can be queried as of that version.
+ *
+ * Nodes form a perfect tree of 'n' leaves (rounded up to a power of 2), and
+ * are never modified once created: an update copies only the nodes on the path
+ * from the root to the updated leaf (the same nodes that gutter_retrieve
+ * recomputes), and the copies share all of their other subtrees with the
+ * previous version. Each version is then one root node. Nodes are allocated
+ * from a pool growing by doubling, and link to each other by 32-bit position
+ * within the pool; collect() releases the versions older than a given one, and
+ * compacts the pool down to the nodes still reachable.
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the associative operation over 'k' sequential elements, as of
+ *	  any version kept
+ *		-> O(log(n))
+ *	- setting/applying a new value to the 'i'th element, as a new version
+ *		-> O(log(n)), and O(log(n)) new nodes
+ *	- constructing from a sequence of 'n' elements
+ *		-> O(n)
+ *	- releasing old versions
+ *		-> O(m), for 'm' nodes still reachable from the versions kept
+ */
+template <typename RESULT_T, typename FUNCTOR_T, typename ALLOC_T=std::allocator<RESULT_T> >
+class gutter_retrieve_persistent {
+	typedef std::size_t INDEX_T;
+	typedef std::uint32_t link_t;	// position within the pool
+
+	struct node_t {
+		RESULT_T value;
+		link_t child[2];	// unused for leaves
+	};
+	typedef typename std::allocator_traits<ALLOC_T>::template rebind_alloc<node_t>
+		node_alloc_t;
+	typedef typename std::allocator_traits<ALLOC_T>::template rebind_alloc<link_t>
+		link_alloc_t;
+	typedef std::vector<node_t, node_alloc_t> pool_t;
+
+	INDEX_T _size;
+	INDEX_T height;	// depth of the leaves
+	FUNCTOR_T op;
+	pool_t pool;
+	// The root of each version kept, starting at version 'first_version'
+	std::vector<link_t, link_alloc_t> roots;
+	INDEX_T first_version;
+
+	inline link_t new_node(const RESULT_T& value, link_t lbranch, link_t rbranch) {
+		node_t created;
+		created.value = value;
+		created.child[0] = lbranch;
+		created.child[1] = rbranch;
+		pool.push_back(created);
+		return link_t(pool.size()-1);
+	}
+	inline link_t new_parent(link_t lbranch, link_t rbranch) {
+		return new_node(op(pool[lbranch].value, pool[rbranch].value), lbranch, rbranch);
+	}
+	// = the branch (0 or 1) toward leaf 'leaf_no' at depth 'depth'
+	inline unsigned branch_toward(INDEX_T leaf_no, INDEX_T depth) const {
+		return (leaf_no >> (height-depth-1)) & 1;
+	}
+
+	// Builds a tree over the leaves, padded with the identity element; padding
+	// subtrees share one node per level
+	template <typename ITER_T>
+	link_t build(ITER_T input, INDEX_T count) {
+		// The first 'live' nodes of each level, followed by padding
+		std::vector<link_t, link_alloc_t> level(pool.get_allocator());
+		level.reserve(count);
+		for (INDEX_T i=0; i<count; ++i, ++input)
+			level.push_back(new_node(*input, 0, 0));
+		link_t padding = new_node(op(), 0, 0);
+		INDEX_T live = count;
+		for (INDEX_T depth=height; depth>0; --depth) {
+			live = (live+1)/2;
+			for (INDEX_T k=0; k<live; ++k)
+				level[k] = new_parent(level[2*k], (2*k+1 < level.size()) ? level[2*k+1] : padding);
+			level.resize(live);
+			padding = new_parent(padding, padding);
+		}
+		return live ? level[0] : padding;
+	}
+
+	// Copies the path from the root of the latest version to the leaf, with
+	// the leaf given a new value; returns the new root
+	link_t update_path(INDEX_T leaf_no, const RESULT_T& x, bool combine) {
+		link_t path[8*sizeof(INDEX_T)+1];
+		link_t p = roots.back();
+		for (INDEX_T depth=0; depth<height; ++depth) {
+			path[depth] = p;
+			p = pool[p].child[branch_toward(leaf_no, depth)];
+		}
+		link_t copied = new_node(combine ? op(pool[p].value, x) : x, 0, 0);
+		for (INDEX_T depth=height; depth-- > 0; ) {
+			const unsigned dir = branch_toward(leaf_no, depth);
+			link_t children[2] = {pool[path[depth]].child[0], pool[path[depth]].child[1]};
+			children[dir] = copied;
+			copied = new_parent(children[0], children[1]);
+		}
+		return copied;
+	}
+
+	RESULT_T accumulate(link_t l, INDEX_T depth, INDEX_T first,
+			INDEX_T leaf1, INDEX_T leaf2) const {
+		const INDEX_T span = INDEX_T(1) << (height-depth);
+		if (leaf2 <= first || first+span <= leaf1)
+			return op();
+		if (leaf1 <= first && first+span <= leaf2)
+			return pool[l].value;
+		// Partially covered, hence not a leaf
+		const RESULT_T lres = accumulate(pool[l].child[0], depth+1, first, leaf1, leaf2);
+		const RESULT_T rres = accumulate(pool[l].child[1], depth+1, first+span/2,
+				leaf1, leaf2);
+		return op(lres, rres);
+	}
+
+	// Copies the subtree at 'l' into another pool, once per node
+	link_t copy_reachable(link_t l, INDEX_T depth, pool_t& to,
+			std::vector<link_t, link_alloc_t>& moved) const {
+		const link_t none = link_t(-1);
+		if (moved[l] != none)
+			return moved[l];
+		node_t copied = pool[l];
+		if (depth < height) {
+			copied.child[0] = copy_reachable(pool[l].child[0], depth+1, to, moved);
+			copied.child[1] = copy_reachable(pool[l].child[1], depth+1, to, moved);
+		}
+		to.push_back(copied);
+		return moved[l] = link_t(to.size()-1);
+	}
+
+public:
+	typedef RESULT_T result_type;
+	typedef FUNCTOR_T functor_type;
+
+	// Constructor (runs in O(log(n)) time)
+	gutter_retrieve_persistent(INDEX_T n, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: _size(n), height(n > 1 ? gutter_log2(n-1)+1 : 0), op(functor),
+			pool(node_alloc_t(allocator)), roots(link_alloc_t(allocator)), first_version(0) {
+		// All leaves are padding
+		roots.push_back(build(static_cast<const RESULT_T*>(0), 0));
+	}
+	// Constructor (runs in O(n) time)
+	template <typename ITER_T, typename=gutter_iterator_category<ITER_T> >
+	gutter_retrieve_persistent(ITER_T first, ITER_T last, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: _size(std::distance(first,last)),
+			height(_size > 1 ? gutter_log2(_size-1)+1 : 0), op(functor),
+			pool(node_alloc_t(allocator)), roots(link_alloc_t(allocator)), first_version(0) {
+		roots.push_back(build(first, _size));
+	}
+	INDEX_T size() const {
+		return _size;
+	}
+	// = the number of the latest version, and of the oldest version kept
+	INDEX_T version() const {
+		return first_version + roots.size()-1;
+	}
+	INDEX_T oldest_version() const {
+		return first_version;
+	}
+	INDEX_T node_count() const {
+		return pool.size();
+	}
+
+	// Access Methods (run in O(log(n)) time)
+	// - each returns the number of the version it creates
+	INDEX_T assign(INDEX_T leaf_no, const RESULT_T& x) {
+		roots.push_back(update_path(leaf_no, x, false));
+		return version();
+	}
+	INDEX_T apply(INDEX_T leaf_no, const RESULT_T& x) {
+		roots.push_back(update_path(leaf_no, x, true));
+		return version();
+	}
+	// - versions released by collect() hold only the identity element
+	RESULT_T get(INDEX_T v, INDEX_T leaf_no) const {
+		return accumulate(v, leaf_no, leaf_no+1);
+	}
+	RESULT_T accumulate(INDEX_T v, INDEX_T leaf1, INDEX_T leaf2) const {
+		if (v < first_version || v > version()) //error?
+			return op();
+		if (leaf1>=leaf2) return op();
+		return accumulate(roots[v-first_version], 0, 0, leaf1, leaf2);
+	}
+	RESULT_T operator[](INDEX_T leaf_no) const {
+		return get(version(), leaf_no);
+	}
+	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
+		return accumulate(version(), leaf1, leaf2);
+	}
+	// = accumulate(v,0,n), read off the root (run in O(1) time)
+	RESULT_T total(INDEX_T v) const {
+		if (v < first_version || v > version()) //error?
+			return op();
+		return pool[roots[v-first_version]].value;
+	}
+
+	// Access Method (runs in O(m) time)
+	// - releases the versions older than 'oldest' (the latest version is
+	//	 always kept), moving the nodes still reachable into a new pool
+	void collect(INDEX_T oldest) {
+		if (oldest > version())
+			oldest = version();
+		if (oldest <= first_version)
+			return;
+		roots.erase(roots.begin(), roots.begin() + (oldest-first_version));
+		first_version = oldest;
+		pool_t kept(pool.get_allocator());
+		std::vector<link_t, link_alloc_t> moved(pool.size(), link_t(-1), roots.get_allocator());
+		for (INDEX_T r=0; r<roots.size(); ++r)
+			roots[r] = copy_reachable(roots[r], 0, kept, moved);
+		kept.shrink_to_fit();
+		pool.swap(kept);
+	}
+};
+
+
+#endif
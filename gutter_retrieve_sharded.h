@@ -0,0 +1,212 @@
+#ifndef GUTTER_RETRIEVE_SHARDED_H
+#define GUTTER_RETRIEVE_SHARDED_H
+
+#include "gutter_parallel.h"
+#include "gutter_retrieve.h"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/*
+ * This class provides the interface of gutter_retrieve over a very large
+ * number of elements, split into 'K' contiguous shards of equal width. Each
+ * shard is its own gutter_retrieve, guarded by its own mutex, and publishes its
+ * total to its own atomic slot of a top row; an operation on one shard thus
+ * never waits on an operation on another.
+ *
+ * A range query combines the partial results of the (up to) two shards at its
+ * ends with the totals of the shards in between, as read from the top row;
+ * it is not a snapshot across shards, but the contribution of each shard is
+ * consistent. Setting a collection of sequential elements, rebuilding, and
+ * batches of range queries are fanned out across a gutter_thread_pool.
+ *
+ * All methods are safe to call from any thread. RESULT_T must be trivially
+ * copyable, as the top row holds a std::atomic<RESULT_T> per shard (which is
+ * only lock-free for small types).
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the associative operation over 'k' sequential elements
+ *		-> O(log(n/K)+min(k*K/n,K))
+ *	- setting/applying a new value to the 'i'th element
+ *		-> O(log(n/K))
+ *	- setting a collection of 'k' sequential elements
+ *		-> O(k/T+log(n)), across 'T' threads
+ *	- computing 'q' range queries at once
+ *		-> O(q*log(n)/T), across 'T' threads
+ *	- constructing/rebuilding from a sequence of 'n' elements
+ *		-> O(n/T+K), across 'T' threads
+ */
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T=gutter_layout_bfs>
+class gutter_retrieve_sharded {
+	typedef std::size_t INDEX_T;
+	typedef gutter_retrieve<RESULT_T, FUNCTOR_T, LAYOUT_T> shard_t;
+
+	const INDEX_T _size;
+	const INDEX_T width;	// leaves per shard (the last shard may be narrower)
+	FUNCTOR_T op;
+	std::vector<shard_t> shards;
+	std::unique_ptr<std::mutex[]> shard_locks;
+	std::unique_ptr<std::atomic<RESULT_T>[]> top;	// the total of each shard
+	std::unique_ptr<gutter_thread_pool> own_pool;
+	gutter_thread_pool& pool;
+
+	inline INDEX_T shard_count() const {
+		return shards.size();
+	}
+	inline INDEX_T shard_first(INDEX_T k) const {
+		return k*width;
+	}
+	inline INDEX_T shard_size(INDEX_T k) const {
+		return std::min(width, _size - k*width);
+	}
+	// = the width of each of 'shard_no' shards over 'n' leaves (a shard_no of
+	//	 0 is taken as 1)
+	static inline INDEX_T width_of(INDEX_T n, INDEX_T shard_no) {
+		shard_no = std::max<INDEX_T>(1, shard_no);
+		return std::max<INDEX_T>(1, (n + shard_no-1) / shard_no);
+	}
+
+	// Publishes the total of shard 'k' to the top row
+	// - the shard's lock must be held, so that totals are published in order
+	inline void update_top(INDEX_T k) {
+		top[k].store(shards[k].total(), std::memory_order_release);
+	}
+	// Partial result over [i1,i2) within shard 'k'
+	inline RESULT_T accumulate_in_shard(INDEX_T k, INDEX_T i1, INDEX_T i2) const {
+		std::lock_guard<std::mutex> guard(shard_locks[k]);
+		return shards[k].accumulate(i1 - shard_first(k), i2 - shard_first(k));
+	}
+
+	void allocate() {
+		const INDEX_T count = (_size + width-1) / width;
+		shards.reserve(count);
+		for (INDEX_T k=0; k<count; ++k)
+			shards.emplace_back(shard_size(k), op);
+		shard_locks.reset(new std::mutex[count]);
+		top.reset(new std::atomic<RESULT_T>[count]);
+		for (INDEX_T k=0; k<count; ++k)
+			top[k].store(shards[k].total(), std::memory_order_relaxed);
+	}
+	// Sets the elements [i1,i2) within shard 'k', from an iterator positioned
+	// at element 'i1'
+	template <typename ITER_T>
+	void assign_in_shard(INDEX_T k, INDEX_T i1, INDEX_T i2, ITER_T input) {
+		std::lock_guard<std::mutex> guard(shard_locks[k]);
+		shards[k].assign(i1 - shard_first(k), i2 - shard_first(k), input);
+		update_top(k);
+	}
+	template <typename ITER_T>
+	void build(ITER_T input) {
+		pool.run(shard_count(), [&](std::size_t k) {
+			std::lock_guard<std::mutex> guard(shard_locks[k]);
+			const ITER_T first = std::next(input, shard_first(k));
+			shards[k].rebuild(first, std::next(first, shard_size(k)));
+			update_top(k);
+		});
+	}
+
+public:
+	// Constructors
+	// - 'pool' must outlive the tree; by default the tree starts its own pool,
+	//	 with one thread per hardware thread
+	// - a 'shard_no' of 0 is taken as 1 (a single shard)
+	gutter_retrieve_sharded(INDEX_T n, INDEX_T shard_no, FUNCTOR_T functor=FUNCTOR_T())
+			: _size(n), width(width_of(n, shard_no)), op(functor),
+			own_pool(new gutter_thread_pool()), pool(*own_pool) {
+		allocate();
+	}
+	gutter_retrieve_sharded(INDEX_T n, INDEX_T shard_no, gutter_thread_pool& threads,
+			FUNCTOR_T functor=FUNCTOR_T())
+			: _size(n), width(width_of(n, shard_no)), op(functor), pool(threads) {
+		allocate();
+	}
+	// Constructor (runs in O(n/T+K) time)
+	// - 'ITER_T' is advanced to the start of each shard, so should be random-access
+	template <typename ITER_T, typename=gutter_iterator_category<ITER_T> >
+	gutter_retrieve_sharded(ITER_T first, ITER_T last, INDEX_T shard_no,
+			FUNCTOR_T functor=FUNCTOR_T())
+			: gutter_retrieve_sharded(std::distance(first,last), shard_no, functor) {
+		build(first);
+	}
+	INDEX_T size() const {
+		return _size;
+	}
+	INDEX_T shard_width() const {
+		return width;
+	}
+
+	// Access Method (runs in O(1) time)
+	RESULT_T operator[](INDEX_T leaf_no) const {
+		const INDEX_T k = leaf_no / width;
+		std::lock_guard<std::mutex> guard(shard_locks[k]);
+		return shards[k][leaf_no - shard_first(k)];
+	}
+	// Access Methods (run in O(log(n/K)) time)
+	void assign(INDEX_T leaf_no, RESULT_T& x) {
+		const INDEX_T k = leaf_no / width;
+		std::lock_guard<std::mutex> guard(shard_locks[k]);
+		shards[k].assign(leaf_no - shard_first(k), x);
+		update_top(k);
+	}
+	void apply(INDEX_T leaf_no, RESULT_T& x) {
+		const INDEX_T k = leaf_no / width;
+		std::lock_guard<std::mutex> guard(shard_locks[k]);
+		shards[k].apply(leaf_no - shard_first(k), x);
+		update_top(k);
+	}
+	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
+		if (leaf1>=leaf2) return op();
+		const INDEX_T k1 = leaf1 / width, k2 = (leaf2-1) / width;
+		if (k1 == k2)
+			return accumulate_in_shard(k1, leaf1, leaf2);
+		RESULT_T res = accumulate_in_shard(k1, leaf1, shard_first(k1+1));
+		for (INDEX_T k=k1+1; k<k2; ++k)
+			res = op(res, top[k].load(std::memory_order_acquire));
+		return op(res, accumulate_in_shard(k2, shard_first(k2), leaf2));
+	}
+	// Access Method (runs in O(q*log(n)/T) time)
+	// - computes out[j] = accumulate(ranges[j].first, ranges[j].second)
+	void accumulate_batch(const std::pair<INDEX_T,INDEX_T>* ranges, std::size_t q,
+			RESULT_T* out) const {
+		// Hands queries out in chunks, to amortize the cost of each task
+		const std::size_t chunk = 256;
+		pool.run((q + chunk-1) / chunk, [&](std::size_t c) {
+			for (std::size_t j=c*chunk; j<std::min(q,(c+1)*chunk); ++j)
+				out[j] = accumulate(ranges[j].first, ranges[j].second);
+		});
+	}
+	// Access Method (runs in O(k/T+log(n)) time)
+	// - 'ITER_T' is advanced to the start of each shard, so should be random-access
+	template <typename ITER_T>
+	ITER_T assign(INDEX_T i1, INDEX_T i2, ITER_T input) {
+		if (i1>=i2) //error?
+			return input;
+		const INDEX_T k1 = i1 / width, k2 = (i2-1) / width;
+		if (k1 == k2) {
+			// Runs inline, rather than tying up the pool for a single task
+			assign_in_shard(k1, i1, i2, input);
+			return std::next(input, i2-i1);
+		}
+		pool.run(k2-k1+1, [&](std::size_t j) {
+			const INDEX_T k = k1+j;
+			const INDEX_T j1 = std::max(i1, shard_first(k));
+			const INDEX_T j2 = std::min(i2, shard_first(k)+shard_size(k));
+			assign_in_shard(k, j1, j2, std::next(input, j1-i1));
+		});
+		return std::next(input, i2-i1);
+	}
+	// Access Method (runs in O(n/T+K) time)
+	template <typename ITER_T>
+	void rebuild(ITER_T first, ITER_T last) {
+		if (INDEX_T(std::distance(first,last)) != _size) //error?
+			return;
+		build(first);
+	}
+};
+
+
+#endif
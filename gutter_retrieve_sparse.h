@@ -0,0 +1,189 @@
+#ifndef GUTTER_RETRIEVE_SPARSE_H
+#define GUTTER_RETRIEVE_SPARSE_H
+
+#include "gutter_base.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * This class provides the interface of gutter_retrieve over a huge domain of
+ * 'n' elements (e.g., 2^40 timestamps), only a few of which ever hold a value
+ * other than the identity element; storage is proportional to the number of
+ * such populated elements, rather than to 'n'.
+ *
+ * Nodes are addressed by the same heap-style indices as in gutter_base, over a
+ * perfect tree of 'n' leaves (rounded up to a power of 2), but only the nodes
+ * needed to reach the populated leaves are stored, and missing subtrees stand
+ * for the identity element. Chains of nodes with a single child are skipped
+ * (as in a radix tree): each stored node links directly to the nearest stored
+ * node of each of its two subtrees, so that 'k' populated leaves take at most
+ * 2'k' nodes. Nodes are allocated from a pool growing by doubling, and link to
+ * each other by 32-bit position within the pool.
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the associative operation over a range of elements
+ *		-> O(log(n))
+ *	- computing/setting/applying a new value to the 'i'th element
+ *		-> O(log(n))
+ *	- storage for 'k' populated elements
+ *		-> O(k)
+ */
+template <typename RESULT_T, typename FUNCTOR_T, typename ALLOC_T=std::allocator<RESULT_T> >
+class gutter_retrieve_sparse {
+	typedef std::size_t INDEX_T;
+	typedef std::uint32_t link_t;	// position within the pool; 0 for none
+
+	struct node_t {
+		INDEX_T id;	// heap-style index
+		RESULT_T value;
+		link_t child[2];
+	};
+	typedef typename std::allocator_traits<ALLOC_T>::template rebind_alloc<node_t>
+		node_alloc_t;
+
+	INDEX_T _size;
+	INDEX_T height;	// depth of the leaves
+	FUNCTOR_T op;
+	// The root (heap index 1) is always at position 0, and is never linked to
+	std::vector<node_t, node_alloc_t> pool;
+
+	static inline bool index_isancestor(INDEX_T anc, INDEX_T index) {
+		// = whether 'anc' is an ancestor of (or equal to) 'index'
+		const INDEX_T da = gutter_log2(anc), di = gutter_log2(index);
+		return da <= di && (index >> (di-da)) == anc;
+	}
+	static inline unsigned index_branch_toward(INDEX_T anc, INDEX_T index) {
+		// = 1 if 'index' descends from the right branch of 'anc', 0 otherwise
+		return (index >> (gutter_log2(index) - gutter_log2(anc) - 1)) & 1;
+	}
+	static inline INDEX_T index_common_ancestor(INDEX_T a, INDEX_T b) {
+		const INDEX_T da = gutter_log2(a), db = gutter_log2(b);
+		if (da > db) a >>= da-db;
+		else b >>= db-da;
+		return (a == b) ? a : a >> (gutter_log2(a^b)+1);
+	}
+	inline INDEX_T index_nth_leaf(INDEX_T n) const {
+		return (INDEX_T(1) << height) + n;
+	}
+
+	inline link_t new_node(INDEX_T id) {
+		node_t created;
+		created.id = id;
+		created.value = op();
+		created.child[0] = created.child[1] = 0;
+		pool.push_back(created);
+		return link_t(pool.size()-1);
+	}
+	inline RESULT_T value_of(link_t l) const {
+		return l ? pool[l].value : op();
+	}
+	inline void update(link_t l) {
+		pool[l].value = op(value_of(pool[l].child[0]), value_of(pool[l].child[1]));
+	}
+
+	// Finds the node of the given leaf, creating it if missing, and stores the
+	// path to it from the root in 'path'; returns the length of the path
+	unsigned find_or_insert(INDEX_T leaf, link_t* path) {
+		unsigned length = 0;
+		link_t p = 0;
+		path[length++] = p;
+		while (pool[p].id != leaf) {
+			const unsigned dir = index_branch_toward(pool[p].id, leaf);
+			const link_t c = pool[p].child[dir];
+			if (!c) {
+				const link_t l = new_node(leaf);
+				pool[p].child[dir] = l;
+				path[length++] = l;
+				return length;
+			}
+			if (index_isancestor(pool[c].id, leaf)) {
+				p = c;
+				path[length++] = p;
+				continue;
+			}
+			// The leaf branches off below 'p', but above 'c'
+			const INDEX_T a = index_common_ancestor(pool[c].id, leaf);
+			const link_t s = new_node(a);
+			const link_t l = new_node(leaf);
+			pool[s].child[index_branch_toward(a, pool[c].id)] = c;
+			pool[s].child[index_branch_toward(a, leaf)] = l;
+			pool[p].child[dir] = s;
+			path[length++] = s;
+			path[length++] = l;
+			return length;
+		}
+		return length;
+	}
+	// Recomputes the path above its last node, leaf-up
+	inline void update_path(const link_t* path, unsigned length) {
+		while (length-- > 1)
+			update(path[length-1]);
+	}
+
+	RESULT_T accumulate(link_t l, INDEX_T leaf1, INDEX_T leaf2) const {
+		const node_t& at = pool[l];
+		const INDEX_T depth = gutter_log2(at.id);
+		const INDEX_T span = INDEX_T(1) << (height-depth);
+		const INDEX_T first = (at.id - (INDEX_T(1) << depth)) * span;
+		if (leaf2 <= first || first+span <= leaf1)
+			return op();
+		if (leaf1 <= first && first+span <= leaf2)
+			return at.value;
+		// Partially covered, hence not a leaf
+		const RESULT_T lres = at.child[0] ? accumulate(at.child[0], leaf1, leaf2) : op();
+		const RESULT_T rres = at.child[1] ? accumulate(at.child[1], leaf1, leaf2) : op();
+		return op(lres, rres);
+	}
+
+public:
+	// Constructor (runs in O(1) time)
+	gutter_retrieve_sparse(INDEX_T n, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: _size(n), height(n > 1 ? gutter_log2(n-1)+1 : 0), op(functor),
+			pool(node_alloc_t(allocator)) {
+		new_node(1);
+	}
+	INDEX_T size() const {
+		return _size;
+	}
+	// = the number of nodes stored, at most 2 per populated element
+	INDEX_T node_count() const {
+		return pool.size();
+	}
+	void reserve(INDEX_T populated) {
+		pool.reserve(2*populated);
+	}
+
+	// Access Methods (run in O(log(n)) time)
+	RESULT_T operator[](INDEX_T leaf_no) const {
+		const INDEX_T leaf = index_nth_leaf(leaf_no);
+		link_t p = 0;
+		while (pool[p].id != leaf) {
+			p = pool[p].child[index_branch_toward(pool[p].id, leaf)];
+			if (!p || !index_isancestor(pool[p].id, leaf))
+				return op();
+		}
+		return pool[p].value;
+	}
+	void assign(INDEX_T leaf_no, const RESULT_T& x) {
+		link_t path[8*sizeof(INDEX_T)+2];
+		const unsigned length = find_or_insert(index_nth_leaf(leaf_no), path);
+		pool[path[length-1]].value = x;
+		update_path(path, length);
+	}
+	void apply(INDEX_T leaf_no, const RESULT_T& x) {
+		link_t path[8*sizeof(INDEX_T)+2];
+		const unsigned length = find_or_insert(index_nth_leaf(leaf_no), path);
+		node_t& leaf = pool[path[length-1]];
+		leaf.value = op(leaf.value, x);
+		update_path(path, length);
+	}
+	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
+		if (leaf1>=leaf2) return op();
+		return accumulate(0, leaf1, leaf2);
+	}
+};
+
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef GUTTER_RETRIEVE_WIDE_H
+#define GUTTER_RETRIEVE_WIDE_H
+
+#include "gutter_alloc.h"
+#include "gutter_base.h"
+#include "gutter_simd.h"
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * This class provides the same interface as gutter_retrieve, but stores its
+ * elements in a 'FANOUT'-ary tree rather than a binary tree: every node
+ * stores the associative operation over its 'FANOUT' children, which are
+ * stored contiguously (e.g., 16 32-bit children fill one 64-byte cache line).
+ * A root-to-leaf path is then only log_FANOUT(n) nodes long, and the work done
+ * within each node is a reduction over contiguous memory (vectorized for
+ * add/min/max over arithmetic types, see gutter_simd.h).
+ *
+ * The tree is stored level by level, starting from the leaves; each level is
+ * padded with identity elements to a multiple of 'FANOUT', and each level
+ * starts on a 64-byte boundary of the storage. By default, the storage is
+ * itself aligned to 64 bytes, so that each block of children starts a cache
+ * line whenever FANOUT*sizeof(RESULT_T) is a multiple of 64.
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- computing the associative operation over 'k' sequential elements
+ *		-> O(FANOUT*log_FANOUT(n))
+ *	- setting/applying a new value to the 'i'th element
+ *		-> O(FANOUT*log_FANOUT(n)), or O(log_FANOUT(n)) to apply a value via a
+ *		   commutative operation
+ *	- setting a collection of 'k' sequential elements
+ *		-> O(k+FANOUT*log_FANOUT(n))
+ *	- constructing/rebuilding from a sequence of 'n' elements
+ *		-> O(n)
+ */
+template <typename RESULT_T, typename FUNCTOR_T, std::size_t FANOUT=16,
+		typename ALLOC_T=gutter_aligned_allocator<RESULT_T,64> >
+class gutter_retrieve_wide {
+	static_assert(FANOUT >= 2, "gutter_retrieve_wide requires a fanout of at least 2");
+
+	typedef std::size_t INDEX_T;
+
+	INDEX_T _size;
+	FUNCTOR_T op;
+	// Start of each level within 'nodes', from the leaves (level 0) up to the
+	// root, plus the end of the root level
+	std::vector<INDEX_T> levels;
+	std::vector<RESULT_T, ALLOC_T> nodes;
+
+	// Selects the cloning constructor
+	struct clone_tag {};
+
+	// = the number of nodes per 64 bytes, if a whole number, or else 1
+	static const INDEX_T line = (64 % sizeof(RESULT_T) == 0) ? 64/sizeof(RESULT_T) : 1;
+
+	static inline INDEX_T padded(INDEX_T k) {
+		return (k + FANOUT-1) / FANOUT * FANOUT;
+	}
+	static inline INDEX_T aligned(INDEX_T k) {
+		return (k + line-1) / line * line;
+	}
+	// Combines 'k' contiguous nodes, in order for non-vectorized functors
+	inline RESULT_T reduce(const RESULT_T* first, INDEX_T k) const {
+		return gutter_simd_reduce(op, first, k);
+	}
+	// Recomputes the nodes [j1,j2) of the given level from their children
+	inline void update_level(INDEX_T lvl, INDEX_T j1, INDEX_T j2) {
+		const RESULT_T* children = &nodes[levels[lvl-1]];
+		RESULT_T* parents = &nodes[levels[lvl]];
+		for (INDEX_T j=j1; j<j2; ++j)
+			parents[j] = reduce(children + j*FANOUT, FANOUT);
+	}
+	// Recomputes all ancestors of the leaves [i1,i2)
+	inline void update_ancestors(INDEX_T i1, INDEX_T i2) {
+		for (INDEX_T lvl=1; lvl+1 < levels.size(); ++lvl) {
+			i1 /= FANOUT;
+			i2 = (i2-1)/FANOUT + 1;
+			update_level(lvl, i1, i2);
+		}
+	}
+
+	void apply(INDEX_T leaf_no, const RESULT_T& x, std::false_type) {
+		nodes[leaf_no] = op(nodes[leaf_no], x);
+		update_ancestors(leaf_no, leaf_no+1);
+	}
+	void apply(INDEX_T leaf_no, const RESULT_T& x, std::true_type) {
+		for (INDEX_T lvl=0; lvl+1 < levels.size(); ++lvl, leaf_no /= FANOUT) {
+			RESULT_T& node = nodes[levels[lvl]+leaf_no];
+			node = op(node, x);
+		}
+	}
+
+	void allocate() {
+		// Each level holds one node per block of the level below, up to a
+		// single root
+		INDEX_T width = _size;
+		levels.push_back(0);
+		while (true) {
+			levels.push_back(aligned(levels.back() + padded(width)));
+			if (width <= 1) break;
+			width = (width + FANOUT-1) / FANOUT;
+		}
+		nodes.assign(levels.back(), op());
+	}
+	template <typename ITER_T>
+	ITER_T build(ITER_T input) {
+		for (INDEX_T i=0; i<_size; ++i, ++input)
+			nodes[i] = *input;
+		// Padding nodes stay the identity element
+		INDEX_T width = _size;
+		for (INDEX_T lvl=1; lvl+1 < levels.size(); ++lvl) {
+			width = (width + FANOUT-1) / FANOUT;
+			update_level(lvl, 0, width);
+		}
+		return input;
+	}
+
+	// Deep-copies the source, in O(n) time
+	gutter_retrieve_wide(const gutter_retrieve_wide& source, clone_tag)
+			: _size(source._size), op(source.op), levels(source.levels),
+			nodes(source.nodes) {}
+
+public:
+	// Constructor
+	gutter_retrieve_wide(INDEX_T n, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: _size(n), op(functor), nodes(allocator) {
+		allocate();
+	}
+	// Constructors (run in O(n) time)
+	gutter_retrieve_wide(std::initializer_list<RESULT_T> source,
+			FUNCTOR_T functor=FUNCTOR_T(), const ALLOC_T& allocator=ALLOC_T())
+			: _size(source.size()), op(functor), nodes(allocator) {
+		allocate();
+		build(source.begin());
+	}
+	template <typename ITER_T, typename=gutter_iterator_category<ITER_T> >
+	gutter_retrieve_wide(ITER_T first, ITER_T last, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: _size(std::distance(first,last)), op(functor), nodes(allocator) {
+		allocate();
+		build(first);
+	}
+	gutter_retrieve_wide(gutter_retrieve_wide&&) = default;
+	gutter_retrieve_wide& operator=(gutter_retrieve_wide&&) = default;
+	gutter_retrieve_wide(const gutter_retrieve_wide&) = delete;
+	gutter_retrieve_wide& operator=(const gutter_retrieve_wide&) = delete;
+	INDEX_T size() const {
+		return _size;
+	}
+	// Deep copy (runs in O(n) time)
+	gutter_retrieve_wide clone() const {
+		return gutter_retrieve_wide(*this, clone_tag());
+	}
+	void swap(gutter_retrieve_wide& other) {
+		std::swap(_size, other._size);
+		std::swap(op, other.op);
+		levels.swap(other.levels);
+		nodes.swap(other.nodes);
+	}
+	// Access Method (run in O(1) time)
+	RESULT_T operator[](INDEX_T leaf_no) const {
+		return nodes[leaf_no];
+	}
+	// Access Methods (run in O(FANOUT*log_FANOUT(n)) time)
+	void assign(INDEX_T leaf_no, RESULT_T& x) {
+		nodes[leaf_no] = x;
+		update_ancestors(leaf_no, leaf_no+1);
+	}
+	// - commutative functors apply 'x' directly to each ancestor, in O(log_FANOUT(n))
+	void apply(INDEX_T leaf_no, RESULT_T& x) {
+		apply(leaf_no, x, gutter_is_commutative<FUNCTOR_T>());
+	}
+	RESULT_T accumulate(INDEX_T leaf1, INDEX_T leaf2) const {
+		RESULT_T lres = op(), rres = op();
+		if (leaf1>=leaf2) return lres;
+		for (INDEX_T lvl=0; ; ++lvl) {
+			const RESULT_T* row = &nodes[levels[lvl]];
+			// Bounds of the full blocks within [leaf1,leaf2), one level up
+			const INDEX_T block1 = (leaf1 + FANOUT-1) / FANOUT;
+			const INDEX_T block2 = leaf2 / FANOUT;
+			if (block1 >= block2) {
+				// No full block left; the rest is a contiguous run
+				lres = op(lres, reduce(row+leaf1, leaf2-leaf1));
+				break;
+			}
+			lres = op(lres, reduce(row+leaf1, block1*FANOUT-leaf1));
+			rres = op(reduce(row+block2*FANOUT, leaf2-block2*FANOUT), rres);
+			leaf1 = block1;
+			leaf2 = block2;
+		}
+		return op(lres, rres);
+	}
+	// Access Method (runs in O(k+FANOUT*log_FANOUT(n)) time)
+	template <typename ITER_T>
+	ITER_T assign(INDEX_T i1, INDEX_T i2, ITER_T input) {
+		if (i1>=i2) //error?
+			return input;
+		for (INDEX_T i=i1; i<i2; ++i, ++input)
+			nodes[i] = *input;
+		update_ancestors(i1, i2);
+		return input;
+	}
+	// Access Method (runs in O(n) time)
+	template <typename ITER_T>
+	void rebuild(ITER_T first, ITER_T last) {
+		if (INDEX_T(std::distance(first,last)) != _size) //error?
+			return;
+		build(first);
+	}
+};
+
+
+#endif
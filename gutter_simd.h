@@ -0,0 +1,375 @@
+#ifndef GUTTER_SIMD_H
+#define GUTTER_SIMD_H
+/*
+ * These are the vectorized kernels for the gutter classes. The central kernel
+ * is a pairwise reduction over contiguous memory, i.e.
+ *		dst[k] = op(src[2k], src[2k+1])	for k = 0, ..., count-1
+ * which recomputes a run of parent nodes from a run of child nodes when the
+ * tree's rows are stored contiguously (e.g., gutter_layout_bfs). A second
+ * kernel reduces a whole run of contiguous memory to one result, i.e.
+ *		op(src[0], ..., src[count-1])
+ * which recomputes a node of a wide tree from its children (see
+ * gutter_retrieve_wide.h); vectorized, it combines the elements in no
+ * particular order, as add/min/max are commutative.
+ *
+ * Vectorized kernels are provided for the add/min/max functors over float,
+ * double, int32_t and int64_t, using whichever instruction set the compiler
+ * targets (AVX2, SSE2/SSE4, or NEON); all other functor/type combinations (or
+ * targets) fall back to a scalar loop. The vectorized kernels give the same
+ * results as the scalar add/min/max functors, including for NaNs and signed
+ * zeros.
+ *
+ * Each vector type description gutter_simd_vec<T> provides:
+ *	- 'vec' and 'width': the vector type and its number of lanes
+ *	- deinterleave(src, ev, od): loads 2*'width' elements, splitting them into
+ *		even and odd elements (possibly in a permuted lane order)
+ *	- store(dst, v): stores a vector, undoing the lane permutation
+ *	- add/min/max(ev, od): same as the scalar add/min/max functors (ev, od)
+ */
+
+#include "gutter_base.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+template <typename T>
+struct gutter_simd_vec {
+	enum { supported = 0, has_minmax = 0 };
+};
+
+#if defined(__AVX2__)
+
+template <>
+struct gutter_simd_vec<float> {
+	enum { supported = 1, has_minmax = 1, width = 8 };
+	typedef __m256 vec;
+	static inline void deinterleave(const float* src, vec& ev, vec& od) {
+		// Lanes come out as pairs (0,1,4,5 | 2,3,6,7)
+		const vec a = _mm256_loadu_ps(src), b = _mm256_loadu_ps(src+width);
+		ev = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+		od = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+	}
+	static inline void store(float* dst, vec v) {
+		_mm256_storeu_ps(dst, _mm256_castpd_ps(_mm256_permute4x64_pd(
+				_mm256_castps_pd(v), _MM_SHUFFLE(3,1,2,0))));
+	}
+	static inline vec add(vec ev, vec od) {return _mm256_add_ps(ev, od);}
+	static inline vec min(vec ev, vec od) {return _mm256_min_ps(od, ev);}
+	static inline vec max(vec ev, vec od) {return _mm256_max_ps(od, ev);}
+};
+template <>
+struct gutter_simd_vec<std::int32_t> {
+	enum { supported = 1, has_minmax = 1, width = 8 };
+	typedef __m256i vec;
+	static inline void deinterleave(const std::int32_t* src, vec& ev, vec& od) {
+		const __m256 a = _mm256_loadu_ps(reinterpret_cast<const float*>(src));
+		const __m256 b = _mm256_loadu_ps(reinterpret_cast<const float*>(src+width));
+		ev = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)));
+		od = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)));
+	}
+	static inline void store(std::int32_t* dst, vec v) {
+		_mm256_storeu_si256(reinterpret_cast<vec*>(dst),
+				_mm256_permute4x64_epi64(v, _MM_SHUFFLE(3,1,2,0)));
+	}
+	static inline vec add(vec ev, vec od) {return _mm256_add_epi32(ev, od);}
+	static inline vec min(vec ev, vec od) {return _mm256_min_epi32(ev, od);}
+	static inline vec max(vec ev, vec od) {return _mm256_max_epi32(ev, od);}
+};
+template <>
+struct gutter_simd_vec<double> {
+	enum { supported = 1, has_minmax = 1, width = 4 };
+	typedef __m256d vec;
+	static inline void deinterleave(const double* src, vec& ev, vec& od) {
+		// Lanes come out in the order (0,2 | 1,3)
+		const vec a = _mm256_loadu_pd(src), b = _mm256_loadu_pd(src+width);
+		ev = _mm256_unpacklo_pd(a, b);
+		od = _mm256_unpackhi_pd(a, b);
+	}
+	static inline void store(double* dst, vec v) {
+		_mm256_storeu_pd(dst, _mm256_permute4x64_pd(v, _MM_SHUFFLE(3,1,2,0)));
+	}
+	static inline vec add(vec ev, vec od) {return _mm256_add_pd(ev, od);}
+	static inline vec min(vec ev, vec od) {return _mm256_min_pd(od, ev);}
+	static inline vec max(vec ev, vec od) {return _mm256_max_pd(od, ev);}
+};
+template <>
+struct gutter_simd_vec<std::int64_t> {
+	enum { supported = 1, has_minmax = 1, width = 4 };
+	typedef __m256i vec;
+	static inline void deinterleave(const std::int64_t* src, vec& ev, vec& od) {
+		const vec a = _mm256_loadu_si256(reinterpret_cast<const vec*>(src));
+		const vec b = _mm256_loadu_si256(reinterpret_cast<const vec*>(src+width));
+		ev = _mm256_unpacklo_epi64(a, b);
+		od = _mm256_unpackhi_epi64(a, b);
+	}
+	static inline void store(std::int64_t* dst, vec v) {
+		_mm256_storeu_si256(reinterpret_cast<vec*>(dst),
+				_mm256_permute4x64_epi64(v, _MM_SHUFFLE(3,1,2,0)));
+	}
+	static inline vec add(vec ev, vec od) {return _mm256_add_epi64(ev, od);}
+	static inline vec min(vec ev, vec od) {
+		return _mm256_blendv_epi8(ev, od, _mm256_cmpgt_epi64(ev, od));
+	}
+	static inline vec max(vec ev, vec od) {
+		return _mm256_blendv_epi8(ev, od, _mm256_cmpgt_epi64(od, ev));
+	}
+};
+
+#elif defined(__SSE2__)
+
+template <>
+struct gutter_simd_vec<float> {
+	enum { supported = 1, has_minmax = 1, width = 4 };
+	typedef __m128 vec;
+	static inline void deinterleave(const float* src, vec& ev, vec& od) {
+		const vec a = _mm_loadu_ps(src), b = _mm_loadu_ps(src+width);
+		ev = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+		od = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+	}
+	static inline void store(float* dst, vec v) {_mm_storeu_ps(dst, v);}
+	static inline vec add(vec ev, vec od) {return _mm_add_ps(ev, od);}
+	static inline vec min(vec ev, vec od) {return _mm_min_ps(od, ev);}
+	static inline vec max(vec ev, vec od) {return _mm_max_ps(od, ev);}
+};
+template <>
+struct gutter_simd_vec<std::int32_t> {
+	enum { supported = 1, has_minmax = 1, width = 4 };
+	typedef __m128i vec;
+	static inline void deinterleave(const std::int32_t* src, vec& ev, vec& od) {
+		const __m128 a = _mm_loadu_ps(reinterpret_cast<const float*>(src));
+		const __m128 b = _mm_loadu_ps(reinterpret_cast<const float*>(src+width));
+		ev = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)));
+		od = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)));
+	}
+	static inline void store(std::int32_t* dst, vec v) {
+		_mm_storeu_si128(reinterpret_cast<vec*>(dst), v);
+	}
+	static inline vec add(vec ev, vec od) {return _mm_add_epi32(ev, od);}
+#if defined(__SSE4_1__)
+	static inline vec min(vec ev, vec od) {return _mm_min_epi32(ev, od);}
+	static inline vec max(vec ev, vec od) {return _mm_max_epi32(ev, od);}
+#else
+	static inline vec min(vec ev, vec od) {
+		const vec mask = _mm_cmpgt_epi32(ev, od);
+		return _mm_or_si128(_mm_and_si128(mask, od), _mm_andnot_si128(mask, ev));
+	}
+	static inline vec max(vec ev, vec od) {
+		const vec mask = _mm_cmpgt_epi32(od, ev);
+		return _mm_or_si128(_mm_and_si128(mask, od), _mm_andnot_si128(mask, ev));
+	}
+#endif
+};
+template <>
+struct gutter_simd_vec<double> {
+	enum { supported = 1, has_minmax = 1, width = 2 };
+	typedef __m128d vec;
+	static inline void deinterleave(const double* src, vec& ev, vec& od) {
+		const vec a = _mm_loadu_pd(src), b = _mm_loadu_pd(src+width);
+		ev = _mm_unpacklo_pd(a, b);
+		od = _mm_unpackhi_pd(a, b);
+	}
+	static inline void store(double* dst, vec v) {_mm_storeu_pd(dst, v);}
+	static inline vec add(vec ev, vec od) {return _mm_add_pd(ev, od);}
+	static inline vec min(vec ev, vec od) {return _mm_min_pd(od, ev);}
+	static inline vec max(vec ev, vec od) {return _mm_max_pd(od, ev);}
+};
+template <>
+struct gutter_simd_vec<std::int64_t> {
+#if defined(__SSE4_2__)
+	enum { supported = 1, has_minmax = 1, width = 2 };
+#else
+	enum { supported = 1, has_minmax = 0, width = 2 };
+#endif
+	typedef __m128i vec;
+	static inline void deinterleave(const std::int64_t* src, vec& ev, vec& od) {
+		const vec a = _mm_loadu_si128(reinterpret_cast<const vec*>(src));
+		const vec b = _mm_loadu_si128(reinterpret_cast<const vec*>(src+width));
+		ev = _mm_unpacklo_epi64(a, b);
+		od = _mm_unpackhi_epi64(a, b);
+	}
+	static inline void store(std::int64_t* dst, vec v) {
+		_mm_storeu_si128(reinterpret_cast<vec*>(dst), v);
+	}
+	static inline vec add(vec ev, vec od) {return _mm_add_epi64(ev, od);}
+#if defined(__SSE4_2__)
+	static inline vec min(vec ev, vec od) {
+		return _mm_blendv_epi8(ev, od, _mm_cmpgt_epi64(ev, od));
+	}
+	static inline vec max(vec ev, vec od) {
+		return _mm_blendv_epi8(ev, od, _mm_cmpgt_epi64(od, ev));
+	}
+#endif
+};
+
+#elif defined(__ARM_NEON)
+
+template <>
+struct gutter_simd_vec<float> {
+	enum { supported = 1, has_minmax = 1, width = 4 };
+	typedef float32x4_t vec;
+	static inline void deinterleave(const float* src, vec& ev, vec& od) {
+		const float32x4x2_t pairs = vld2q_f32(src);
+		ev = pairs.val[0];
+		od = pairs.val[1];
+	}
+	static inline void store(float* dst, vec v) {vst1q_f32(dst, v);}
+	static inline vec add(vec ev, vec od) {return vaddq_f32(ev, od);}
+	static inline vec min(vec ev, vec od) {return vbslq_f32(vcltq_f32(od, ev), od, ev);}
+	static inline vec max(vec ev, vec od) {return vbslq_f32(vcltq_f32(ev, od), od, ev);}
+};
+template <>
+struct gutter_simd_vec<std::int32_t> {
+	enum { supported = 1, has_minmax = 1, width = 4 };
+	typedef int32x4_t vec;
+	static inline void deinterleave(const std::int32_t* src, vec& ev, vec& od) {
+		const int32x4x2_t pairs = vld2q_s32(src);
+		ev = pairs.val[0];
+		od = pairs.val[1];
+	}
+	static inline void store(std::int32_t* dst, vec v) {vst1q_s32(dst, v);}
+	static inline vec add(vec ev, vec od) {return vaddq_s32(ev, od);}
+	static inline vec min(vec ev, vec od) {return vminq_s32(ev, od);}
+	static inline vec max(vec ev, vec od) {return vmaxq_s32(ev, od);}
+};
+#if defined(__aarch64__)
+template <>
+struct gutter_simd_vec<double> {
+	enum { supported = 1, has_minmax = 1, width = 2 };
+	typedef float64x2_t vec;
+	static inline void deinterleave(const double* src, vec& ev, vec& od) {
+		const float64x2x2_t pairs = vld2q_f64(src);
+		ev = pairs.val[0];
+		od = pairs.val[1];
+	}
+	static inline void store(double* dst, vec v) {vst1q_f64(dst, v);}
+	static inline vec add(vec ev, vec od) {return vaddq_f64(ev, od);}
+	static inline vec min(vec ev, vec od) {return vbslq_f64(vcltq_f64(od, ev), od, ev);}
+	static inline vec max(vec ev, vec od) {return vbslq_f64(vcltq_f64(ev, od), od, ev);}
+};
+template <>
+struct gutter_simd_vec<std::int64_t> {
+	enum { supported = 1, has_minmax = 1, width = 2 };
+	typedef int64x2_t vec;
+	static inline void deinterleave(const std::int64_t* src, vec& ev, vec& od) {
+		const int64x2x2_t pairs = vld2q_s64(src);
+		ev = pairs.val[0];
+		od = pairs.val[1];
+	}
+	static inline void store(std::int64_t* dst, vec v) {vst1q_s64(dst, v);}
+	static inline vec add(vec ev, vec od) {return vaddq_s64(ev, od);}
+	static inline vec min(vec ev, vec od) {return vbslq_s64(vcltq_s64(od, ev), od, ev);}
+	static inline vec max(vec ev, vec od) {return vbslq_s64(vcltq_s64(ev, od), od, ev);}
+};
+#endif
+
+#endif
+
+// Maps a functor to its vector operation, if any
+template <typename T, typename FUNCTOR_T>
+struct gutter_simd_op {
+	enum { supported = 0 };
+};
+template <typename T>
+struct gutter_simd_op<T, add<T> > {
+	enum { supported = gutter_simd_vec<T>::supported };
+	template <typename V>
+	static inline V apply(V ev, V od) {return gutter_simd_vec<T>::add(ev, od);}
+};
+template <typename T>
+struct gutter_simd_op<T, min<T> > {
+	enum { supported = gutter_simd_vec<T>::has_minmax };
+	template <typename V>
+	static inline V apply(V ev, V od) {return gutter_simd_vec<T>::min(ev, od);}
+};
+template <typename T>
+struct gutter_simd_op<T, max<T> > {
+	enum { supported = gutter_simd_vec<T>::has_minmax };
+	template <typename V>
+	static inline V apply(V ev, V od) {return gutter_simd_vec<T>::max(ev, od);}
+};
+
+template <typename T, typename FUNCTOR_T>
+inline void gutter_simd_reduce_pairs(const FUNCTOR_T& op, T* dst, const T* src,
+		std::size_t count, std::false_type) {
+	for (std::size_t k=0; k<count; ++k) {
+		gutter_combine<FUNCTOR_T>::pair(op, dst[k], src[2*k], src[2*k+1]);
+	}
+}
+template <typename T, typename FUNCTOR_T>
+inline void gutter_simd_reduce_pairs(const FUNCTOR_T& op, T* dst, const T* src,
+		std::size_t count, std::true_type) {
+	typedef gutter_simd_vec<T> V;
+	std::size_t k = 0;
+	for (; k+V::width <= count; k += V::width) {
+		typename V::vec ev, od;
+		V::deinterleave(src+2*k, ev, od);
+		V::store(dst+k, gutter_simd_op<T,FUNCTOR_T>::apply(ev, od));
+	}
+	for (; k<count; ++k) {
+		gutter_combine<FUNCTOR_T>::pair(op, dst[k], src[2*k], src[2*k+1]);
+	}
+}
+// Sets dst[k] = op(src[2k], src[2k+1]) for k < count ('dst' and 'src' must not
+// overlap)
+template <typename T, typename FUNCTOR_T>
+inline void gutter_simd_reduce_pairs(const FUNCTOR_T& op, T* dst, const T* src,
+		std::size_t count) {
+	gutter_simd_reduce_pairs(op, dst, src, count,
+			std::integral_constant<bool, bool(gutter_simd_op<T,FUNCTOR_T>::supported)>());
+}
+
+template <typename T, typename FUNCTOR_T>
+inline T gutter_simd_reduce(const FUNCTOR_T& op, const T* src, std::size_t count,
+		std::false_type) {
+	T res = op();
+	for (std::size_t k=0; k<count; ++k)
+		gutter_combine<FUNCTOR_T>::into(op, res, src[k]);
+	return res;
+}
+template <typename T, typename FUNCTOR_T>
+inline T gutter_simd_reduce(const FUNCTOR_T& op, const T* src, std::size_t count,
+		std::true_type) {
+	typedef gutter_simd_vec<T> V;
+	typedef gutter_simd_op<T,FUNCTOR_T> O;
+	T res = op();
+	std::size_t k = 0;
+	if (count >= 2*V::width) {
+		// Combines the elements lane-wise, then the lanes
+		typename V::vec ev, od;
+		V::deinterleave(src, ev, od);
+		typename V::vec acc = O::apply(ev, od);
+		for (k = 2*V::width; k+2*V::width <= count; k += 2*V::width) {
+			V::deinterleave(src+k, ev, od);
+			acc = O::apply(acc, O::apply(ev, od));
+		}
+		T lanes[V::width];
+		V::store(lanes, acc);
+		for (std::size_t j=0; j<std::size_t(V::width); ++j)
+			res = op(res, lanes[j]);
+	}
+	for (; k<count; ++k)
+		res = op(res, src[k]);
+	return res;
+}
+// = op(src[0], ..., src[count-1]), in order unless vectorized
+template <typename T, typename FUNCTOR_T>
+inline T gutter_simd_reduce(const FUNCTOR_T& op, const T* src, std::size_t count) {
+	return gutter_simd_reduce(op, src, count,
+			std::integral_constant<bool, bool(gutter_simd_op<T,FUNCTOR_T>::supported)>());
+}
+
+#endif
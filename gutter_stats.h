@@ -0,0 +1,247 @@
+#ifndef GUTTER_STATS_H
+#define GUTTER_STATS_H
+/*
+ * These are the instrumentation policies for the gutter classes, counting the
+ * work done by the node-collection operation methods of gutter_base (i.e., the
+ * act_on_* methods, and the accumulate walks of gutter_retrieve).
+ *
+ * Each instrumentation policy provides the following members:
+ *	- walk_begin()/walk_end(): called around each node-collection operation
+ *		(operations may nest, or overlap as in accumulate_batch; only the
+ *		outermost ones are counted as walks, so that methods making several
+ *		passes, e.g. a range assign or a copy, count as one walk)
+ *	- level(): called once per row of the tree traversed
+ *	- visit(k): called once per invocation of a node functor, acting on 'k'
+ *		nodes at once
+ *	- stats(): the counts so far, as a gutter_stats; and reset()
+ *
+ * The following policies are provided:
+ *	- gutter_stats_none: counts nothing, and compiles away entirely (default)
+ *	- gutter_stats_counting: counts walks, functor invocations, nodes and
+ *		levels, in plain (i.e., not thread-safe) counters
+ *	- gutter_stats_perf: also reads hardware counters (cycles, instructions,
+ *		cache misses) through perf_event_open at the start and end of each
+ *		outermost walk, for the thread that constructed the tree (on Linux, and
+ *		where the kernel allows it; see hardware()); each read is a system call,
+ *		so this policy is only suited to sampling
+ *
+ * Counters are per tree, and start at zero for clones and new trees.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define GUTTER_STATS_PERF 1
+#endif
+
+// The counts collected by an instrumentation policy, in a flat struct of
+// 64-bit counters (e.g., for exporting to a metrics pipeline)
+struct gutter_stats {
+	std::uint64_t walks;	// node-collection operations
+	std::uint64_t invocations;	// node functor calls
+	std::uint64_t nodes;	// nodes acted on by the node functors
+	std::uint64_t levels;	// rows of the tree traversed
+	// Hardware counters, over the walks (0 unless read through gutter_stats_perf)
+	std::uint64_t cycles;
+	std::uint64_t instructions;
+	std::uint64_t cache_misses;
+
+	gutter_stats() {
+		std::memset(this, 0, sizeof(*this));
+	}
+	gutter_stats& operator+=(const gutter_stats& other) {
+		walks += other.walks;
+		invocations += other.invocations;
+		nodes += other.nodes;
+		levels += other.levels;
+		cycles += other.cycles;
+		instructions += other.instructions;
+		cache_misses += other.cache_misses;
+		return *this;
+	}
+};
+
+struct gutter_stats_none {
+	inline void walk_begin() {}
+	inline void walk_end() {}
+	inline void level() {}
+	inline void visit(std::size_t) {}
+	gutter_stats stats() const {
+		return gutter_stats();
+	}
+	void reset() {}
+};
+
+class gutter_stats_counting {
+protected:
+	gutter_stats counts;
+	unsigned depth;	// of nested/overlapping walks
+public:
+	gutter_stats_counting() : depth(0) {}
+
+	// Returns true for the start of an outermost walk
+	inline bool walk_begin() {
+		if (depth++ > 0)
+			return false;
+		++counts.walks;
+		return true;
+	}
+	// Returns true for the end of an outermost walk
+	inline bool walk_end() {
+		return --depth == 0;
+	}
+	inline void level() {
+		++counts.levels;
+	}
+	inline void visit(std::size_t nodes) {
+		++counts.invocations;
+		counts.nodes += nodes;
+	}
+	gutter_stats stats() const {
+		return counts;
+	}
+	void reset() {
+		counts = gutter_stats();
+	}
+};
+
+#if defined(GUTTER_STATS_PERF)
+class gutter_stats_perf : public gutter_stats_counting {
+private:
+	enum { events = 3 };
+	int group;	// fd of the group leader, or -1 if unavailable
+	int fds[events];
+	std::uint64_t start[events];
+
+	static int open_event(std::uint64_t config, int leader) {
+		struct perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = config;
+		attr.disabled = (leader < 0);
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP;
+		return int(syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0));
+	}
+	void close_events() {
+		for (unsigned e=0; e<events; ++e) {
+			if (fds[e] >= 0)
+				::close(fds[e]);
+			fds[e] = -1;
+		}
+		group = -1;
+	}
+	// Reads all counters of the group at once
+	bool read_events(std::uint64_t* values) const {
+		std::uint64_t buffer[1+events];
+		if (::read(group, buffer, sizeof(buffer)) != ssize_t(sizeof(buffer))) //error?
+			return false;
+		std::memcpy(values, buffer+1, sizeof(std::uint64_t)*events);
+		return true;
+	}
+
+public:
+	gutter_stats_perf() : group(-1) {
+		fds[0] = open_event(PERF_COUNT_HW_CPU_CYCLES, -1);
+		fds[1] = fds[0] < 0 ? -1 : open_event(PERF_COUNT_HW_INSTRUCTIONS, fds[0]);
+		fds[2] = fds[1] < 0 ? -1 : open_event(PERF_COUNT_HW_CACHE_MISSES, fds[0]);
+		if (fds[2] < 0) { //error?
+			close_events();
+			return;
+		}
+		group = fds[0];
+		ioctl(group, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(group, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+	gutter_stats_perf(gutter_stats_perf&& other) : gutter_stats_counting(other), group(-1) {
+		fds[0] = fds[1] = fds[2] = -1;
+		swap(other);
+	}
+	gutter_stats_perf& operator=(gutter_stats_perf&& other) {
+		swap(other);
+		return *this;
+	}
+	gutter_stats_perf(const gutter_stats_perf&) = delete;
+	gutter_stats_perf& operator=(const gutter_stats_perf&) = delete;
+	~gutter_stats_perf() {
+		close_events();
+	}
+	void swap(gutter_stats_perf& other) {
+		std::swap(counts, other.counts);
+		std::swap(depth, other.depth);
+		std::swap(group, other.group);
+		for (unsigned e=0; e<events; ++e) {
+			std::swap(fds[e], other.fds[e]);
+			std::swap(start[e], other.start[e]);
+		}
+	}
+	// = whether the hardware counters could be opened
+	bool hardware() const {
+		return group >= 0;
+	}
+
+	inline void walk_begin() {
+		if (gutter_stats_counting::walk_begin() && group >= 0 && !read_events(start))
+			close_events();
+	}
+	inline void walk_end() {
+		std::uint64_t end[events];
+		if (!gutter_stats_counting::walk_end() || group < 0)
+			return;
+		if (!read_events(end)) { //error?
+			close_events();
+			return;
+		}
+		counts.cycles += end[0]-start[0];
+		counts.instructions += end[1]-start[1];
+		counts.cache_misses += end[2]-start[2];
+	}
+};
+#endif
+
+// Calls walk_begin()/walk_end() on an instrumentation policy around a scope
+template <typename STATS_T>
+class gutter_stats_scope {
+private:
+	STATS_T& instrument;
+public:
+	explicit gutter_stats_scope(STATS_T& s) : instrument(s) {
+		instrument.walk_begin();
+	}
+	~gutter_stats_scope() {
+		instrument.walk_end();
+	}
+	gutter_stats_scope(const gutter_stats_scope&) = delete;
+	gutter_stats_scope& operator=(const gutter_stats_scope&) = delete;
+};
+
+// Forwards calls to a node functor (held by reference), counting them as visits
+// of one node (F(index)) or of a run of nodes (F(j1,j2))
+template <typename F, typename STATS_T>
+class gutter_stats_counted {
+private:
+	F& functor;
+	STATS_T& instrument;
+public:
+	gutter_stats_counted(F& f, STATS_T& s) : functor(f), instrument(s) {}
+	inline void operator()(std::size_t index) {
+		instrument.visit(1);
+		functor(index);
+	}
+	inline void operator()(std::size_t j1, std::size_t j2) {
+		instrument.visit(j2-j1+1);
+		functor(j1, j2);
+	}
+};
+
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef GUTTER_WINDOW_H
+#define GUTTER_WINDOW_H
+
+#include "gutter_retrieve.h"
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/*
+ * This class computes an associative operation over the last 'W' elements
+ * pushed onto a stream (a sliding window of width 'W'), e.g., a rolling
+ * min/max/sum.
+ *
+ * The window is a ring buffer over the leaves of a gutter_retrieve of 'W'
+ * elements: each element overwrites the oldest one, and the window result
+ * combines the leaves from the oldest element to the end, then from the start
+ * to the newest element (so that elements are combined in order); leaves not
+ * yet written hold the identity element. For commutative functors, the window
+ * result is read off the root instead.
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- pushing an element
+ *		-> O(log(W))
+ *	- pushing 'k' elements at once
+ *		-> O(k+log(W)), through the range assign of gutter_retrieve
+ *	- computing the operation over the window
+ *		-> O(log(W)), or O(1) for commutative functors
+ *	- computing the operation over the 'k' newest elements
+ *		-> O(log(W))
+ */
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T=gutter_layout_bfs,
+		typename ALLOC_T=std::allocator<RESULT_T> >
+class gutter_window {
+	typedef std::size_t INDEX_T;
+
+	gutter_retrieve<RESULT_T, FUNCTOR_T, LAYOUT_T, ALLOC_T> ring;
+	INDEX_T head;	// = the leaf of the oldest element, to be overwritten next
+	INDEX_T count;	// = the number of elements in the window (up to 'W')
+	FUNCTOR_T op;
+
+	// = the operation over the ring positions [i1,i2) followed by [0,i3)
+	inline RESULT_T accumulate_wrapped(INDEX_T i1, INDEX_T i2, INDEX_T i3) const {
+		return op(ring.accumulate(i1, i2), ring.accumulate(0, i3));
+	}
+	RESULT_T window_result(std::false_type) const {
+		return accumulate_wrapped(head, ring.size(), head);
+	}
+	RESULT_T window_result(std::true_type) const {
+		return ring.total();
+	}
+
+public:
+	// Constructor
+	// - 'width' must be at least 1
+	gutter_window(INDEX_T width, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: ring(width, functor, allocator), head(0), count(0), op(functor) {}
+	// = the number of elements in the window, up to width()
+	INDEX_T size() const {
+		return count;
+	}
+	INDEX_T width() const {
+		return ring.size();
+	}
+
+	// Access Method (runs in O(log(W)) time)
+	void push(const RESULT_T& x) {
+		RESULT_T value = x;
+		ring.assign(head, value);
+		head = (head+1 == ring.size()) ? 0 : head+1;
+		if (count < ring.size())
+			++count;
+	}
+	// Access Method (runs in O(k+log(W)) time)
+	// - only the last 'W' of the 'k' elements are written
+	template <typename ITER_T>
+	ITER_T push_n(ITER_T input, INDEX_T k) {
+		const INDEX_T w = ring.size();
+		for (; k > w; --k, ++input)
+			head = (head+1 == w) ? 0 : head+1;
+		count = (count+k < w) ? count+k : w;
+		// Up to the end of the ring, then wrapping around to its start
+		const INDEX_T first = (k < w-head) ? k : w-head;
+		input = ring.assign(head, head+first, input);
+		input = ring.assign(0, k-first, input);
+		head = (head+k) % w;
+		return input;
+	}
+
+	// Access Method (runs in O(log(W)) time, or O(1) for commutative functors)
+	// = the operation over the window, from the oldest element to the newest
+	RESULT_T window_result() const {
+		return window_result(gutter_is_commutative<FUNCTOR_T>());
+	}
+	// Access Method (runs in O(log(W)) time)
+	// = the operation over the 'k' newest elements (or the whole window, if
+	//	 it holds fewer)
+	RESULT_T newest_result(INDEX_T k) const {
+		if (k > count)
+			k = count;
+		if (k <= head)
+			return ring.accumulate(head-k, head);
+		return accumulate_wrapped(ring.size()-(k-head), ring.size(), head);
+	}
+};
+
+/*
+ * This class provides the interface of gutter_window for when only the result
+ * over the whole window is needed, as a queue of two stacks: elements are
+ * pushed onto a back stack, which keeps the operation over all of its elements;
+ * whenever the oldest element must leave and the front stack is empty, the
+ * back stack is moved onto the front stack, which keeps the operation over each
+ * of its suffixes (i.e., from each element to the newest one moved).
+ *
+ * OPERATIONS & COMPLEXITY
+ * 	- pushing an element
+ *		-> amortized O(1), worst case O(W) (when the stacks are flipped)
+ *	- computing the operation over the window
+ *		-> O(1)
+ */
+template <typename RESULT_T, typename FUNCTOR_T, typename ALLOC_T=std::allocator<RESULT_T> >
+class gutter_window_stacks {
+	typedef std::size_t INDEX_T;
+
+	INDEX_T _width;
+	FUNCTOR_T op;
+	// Results of the suffixes of the front stack, the oldest element's last
+	std::vector<RESULT_T, ALLOC_T> front;
+	// Elements of the back stack, oldest first, and the operation over them
+	std::vector<RESULT_T, ALLOC_T> back;
+	RESULT_T back_result;
+
+	void flip() {
+		RESULT_T res = op();
+		while (!back.empty()) {
+			res = op(back.back(), res);
+			front.push_back(res);
+			back.pop_back();
+		}
+		back_result = op();
+	}
+
+public:
+	// Constructor
+	// - 'width' must be at least 1
+	gutter_window_stacks(INDEX_T width, FUNCTOR_T functor=FUNCTOR_T(),
+			const ALLOC_T& allocator=ALLOC_T())
+			: _width(width), op(functor), front(allocator), back(allocator),
+			back_result(functor()) {
+		front.reserve(width);
+		back.reserve(width);
+	}
+	INDEX_T size() const {
+		return front.size() + back.size();
+	}
+	INDEX_T width() const {
+		return _width;
+	}
+
+	// Access Method (runs in amortized O(1) time)
+	void push(const RESULT_T& x) {
+		if (size() == _width) {
+			if (front.empty())
+				flip();
+			front.pop_back();
+		}
+		back.push_back(x);
+		back_result = op(back_result, x);
+	}
+	template <typename ITER_T>
+	ITER_T push_n(ITER_T input, INDEX_T k) {
+		for (; k > 0; --k, ++input)
+			push(*input);
+		return input;
+	}
+
+	// Access Method (runs in O(1) time)
+	RESULT_T window_result() const {
+		return front.empty() ? back_result : op(front.back(), back_result);
+	}
+};
+
+
+#endif
@@ -0,0 +1,187 @@
+#include "gutter_alloc.h"
+#include "gutter_apply.h"
+#include "gutter_retrieve.h"
+#include "gutter_retrieve_wide.h"
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+// Checks that trees built on each allocator of gutter_alloc.h, and on
+// caller-provided storage, are placed where the allocator says and hold their
+// elements; built a second time with GUTTER_NO_MADVISE defined, to check the
+// heap fallback of gutter_hugepage_allocator
+class test_gutter_alloc {
+private:
+	typedef std::size_t INDEX_T;
+
+	std::vector<long> values;
+	const INDEX_T size;
+
+	static bool aligned_to(const void* p, std::size_t align) {
+		return reinterpret_cast<std::uintptr_t>(p) % align == 0;
+	}
+	template <typename TREE_T>
+	bool check_tree(const TREE_T& tree, const std::vector<long>& expected, const char* name) const {
+		for (INDEX_T i=0; i<size; ++i) {
+			long tmp = 0;
+			for (INDEX_T j=i; j<=size; ++j) {
+				if (tree.accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - " << name << " [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << tree.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+				if (j < size)
+					tmp += expected[j];
+			}
+		}
+		return true;
+	}
+	static bool check(bool condition, const char* name) {
+		if (!condition)
+			std::cout << "FAILURE - " << name << std::endl;
+		return condition;
+	}
+public:
+	test_gutter_alloc(INDEX_T length) : values(length), size(length) {
+		for (INDEX_T i=0; i<size; ++i)
+			values[i] = (rand()%200000)-100000;
+	}
+
+	bool test_aligned() {
+		gutter_retrieve<long,add<long>,gutter_layout_bfs,gutter_aligned_allocator<long,64> >
+				rsh(values.begin(), values.end());
+		gutter_retrieve<long,add<long>,gutter_layout_bfs,gutter_aligned_allocator<long,4096> >
+				page(values.begin(), values.end());
+		gutter_retrieve_wide<long,add<long>,8> wide(values.begin(), values.end());
+		return check(aligned_to(rsh.data(), 64), "aligned<64> storage")
+				&& check(aligned_to(page.data(), 4096), "aligned<4096> storage")
+				&& check_tree(rsh, values, "aligned<64>") && check_tree(page, values, "aligned<4096>")
+				&& check_tree(wide, values, "wide");
+	}
+	bool test_hugepage() {
+		gutter_retrieve<long,add<long>,gutter_layout_bfs,gutter_hugepage_allocator<long> >
+				rsh(values.begin(), values.end());
+		if (!check(aligned_to(rsh.data(), std::size_t(1) << 21), "hugepage storage"))
+			return false;
+		// Releases a clone, then allocates and checks another tree
+		{
+			gutter_retrieve<long,add<long>,gutter_layout_bfs,gutter_hugepage_allocator<long> >
+					copy = rsh.clone();
+			if (!check_tree(copy, values, "hugepage clone"))
+				return false;
+		}
+		gutter_apply<long,add<long>,gutter_layout_bfs,gutter_hugepage_allocator<long> > ash(size);
+		return check(aligned_to(ash.data(), std::size_t(1) << 21), "hugepage apply storage")
+				&& check_tree(rsh, values, "hugepage");
+	}
+	// Several trees out of one arena must not overlap, nor run past its end
+	bool test_arena() {
+		typedef gutter_retrieve<long,add<long>,gutter_layout_bfs,gutter_arena_allocator<long> > tree_t;
+		typedef gutter_apply<long,add<long>,gutter_layout_bfs,gutter_arena_allocator<long> > apply_t;
+		const std::size_t bytes = 3*(tree_t::storage_size(size)*sizeof(long) + size + 64);
+		std::vector<char> buffer(bytes);
+		gutter_arena arena(buffer.data(), bytes);
+		const gutter_arena_allocator<long> alloc(arena);
+
+		std::vector<long> others(size);
+		for (INDEX_T i=0; i<size; ++i)
+			others[i] = (rand()%200000)-100000;
+		tree_t rsh1(values.begin(), values.end(), add<long>(), alloc);
+		apply_t ash(size, add<long>(), alloc);
+		tree_t rsh2(others.begin(), others.end(), add<long>(), alloc);
+		for (INDEX_T i=0; i<size; ++i) {
+			long x = others[i];
+			ash.apply(i, x);
+		}
+		const char* const lo = buffer.data();
+		const char* const hi = buffer.data()+bytes;
+		const char* const first1 = reinterpret_cast<const char*>(rsh1.data());
+		const char* const first2 = reinterpret_cast<const char*>(ash.data());
+		const char* const first3 = reinterpret_cast<const char*>(rsh2.data());
+		const std::size_t length = tree_t::storage_size(size)*sizeof(long);
+		if (!check(lo <= first1 && first1+length <= first2 && first2+length <= first3
+					&& first3+length <= hi, "arena trees overlap or overflow")
+				|| !check(aligned_to(first1, alignof(long)) && aligned_to(first2, alignof(long))
+					&& aligned_to(first3, alignof(long)), "arena alignment")
+				|| !check_tree(rsh1, values, "arena 1") || !check_tree(rsh2, others, "arena 3"))
+			return false;
+		for (INDEX_T i=0; i<size; ++i) {
+			if (ash[i] != others[i]) {
+				std::cout << "FAILURE - arena 2 [" << i << ']' << std::endl;
+				std::cout << "alg: \t" << ash[i] << std::endl;
+				std::cout << "true:\t" << others[i] << std::endl;
+				return false;
+			}
+		}
+		// A tree that does not fit must throw, and leave the arena as it was
+		const std::size_t remaining = arena.remaining();
+		try {
+			tree_t rsh3(remaining/sizeof(long) + 1, add<long>(), alloc);
+			return check(false, "arena overflow did not throw");
+		} catch (const std::bad_alloc&) {
+		}
+		return check(arena.remaining() == remaining, "arena overflow used memory");
+	}
+	// Trees over caller-provided storage, then adopting that storage as built
+	bool test_storage() {
+		typedef gutter_retrieve<long,add<long> > tree_t;
+		std::vector<long> storage(tree_t::storage_size(size));
+		{
+			tree_t rsh(size, storage.data());
+			rsh.assign(0, size, values.begin());
+			if (!check(rsh.data() == storage.data(), "caller storage") || !check_tree(rsh, values, "caller"))
+				return false;
+		}
+		// The storage outlives the tree that built it
+		tree_t adopted(size, storage.data(), gutter_adopt_storage());
+		if (!check(adopted.data() == storage.data(), "adopted storage")
+				|| !check_tree(adopted, values, "adopted"))
+			return false;
+
+		typedef gutter_apply<long,add<long> > apply_t;
+		std::vector<long> applied(apply_t::storage_size(size));
+		{
+			apply_t ash(size, applied.data());
+			for (INDEX_T i=0; i<size; ++i) {
+				long x = values[i];
+				ash.apply(i, x);
+			}
+		}
+		apply_t ash(size, applied.data(), gutter_adopt_storage());
+		for (INDEX_T i=0; i<size; ++i) {
+			if (ash[i] != values[i]) {
+				std::cout << "FAILURE - adopted apply [" << i << ']' << std::endl;
+				std::cout << "alg: \t" << ash[i] << std::endl;
+				std::cout << "true:\t" << values[i] << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool test_all() {
+		return test_aligned() && test_hugepage() && test_arena() && test_storage();
+	}
+};
+
+int main() {
+	std::cout << "Test suite:\tgutter_alloc.h allocators" << std::endl;
+#if defined(GUTTER_NO_MADVISE)
+	std::cout << "\ttarget:\taligned, hugepage (heap fallback), arena allocators, caller-provided and adopted storage" << std::endl;
+#else
+	std::cout << "\ttarget:\taligned, hugepage, arena allocators, caller-provided and adopted storage" << std::endl;
+#endif
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	bool passed = true;
+	const std::size_t sizes[] = {1, 2, 7, 64, 100, 333};
+	for (unsigned s=0; s<6 && passed; ++s)
+		passed = test_gutter_alloc(sizes[s]).test_all();
+	if (passed)
+		std::cout << "Test passed." << std::endl;
+	return passed ? 0 : 1;
+}
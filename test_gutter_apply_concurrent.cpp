@@ -0,0 +1,93 @@
+#include "gutter_apply_concurrent.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+template <typename RESULT_T>
+class test_gutter_apply_concurrent {
+private:
+	typedef std::size_t INDEX_T;
+
+	gutter_apply_concurrent<RESULT_T,add<RESULT_T> > ash;
+	const INDEX_T size;
+	const INDEX_T watched;	// the element checked while writers run
+	// Numbers of applies covering 'watched' started/finished so far
+	std::atomic<RESULT_T> started, finished;
+	std::atomic<bool> stop;
+public:
+	test_gutter_apply_concurrent(INDEX_T length)
+	: ash(length), size(length), watched(length/2), started(0), finished(0), stop(false) {}
+
+	// Applies 1 to random ranges, recording the ranges in 'applied'
+	void writer(unsigned seed, std::vector<std::pair<INDEX_T,INDEX_T> >& applied) {
+		while (!stop.load()) {
+			const INDEX_T index1 = rand_r(&seed)%size;
+			const INDEX_T index2 = index1 + 1 + rand_r(&seed)%(size-index1);
+			const bool covers = (index1 <= watched && watched < index2);
+			if (covers)
+				started.fetch_add(1);
+			ash.apply(index1, index2, 1);
+			if (covers)
+				finished.fetch_add(1);
+			applied.push_back(std::make_pair(index1, index2));
+		}
+	}
+	// Checks that each read includes every apply finished before it started,
+	// and no apply started after it ended
+	bool reader(unsigned reads) {
+		for (unsigned r=0; r<reads; ++r) {
+			const RESULT_T lo = finished.load();
+			const RESULT_T res = ash[watched];
+			const RESULT_T hi = started.load();
+			if (res < lo || hi < res) {
+				std::cout << "FAILURE - [" << watched << "] read " << res
+						<< ", outside [" << lo << ", " << hi << ']' << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned writers, unsigned reads) {
+		std::cout << "Test suite:\tgutter_apply_concurrent<T,+> class" << std::endl;
+		std::cout << "\ttarget:\tapply(I,I,T), operator[] methods, concurrently" << std::endl;
+		std::cout << "\ttype:\tstress test" << std::endl;
+
+		std::cout << "Beginning Test." << std::endl;
+		std::vector<std::vector<std::pair<INDEX_T,INDEX_T> > > applied(writers);
+		std::vector<std::thread> threads;
+		for (unsigned w=0; w<writers; ++w)
+			threads.push_back(std::thread(&test_gutter_apply_concurrent::writer, this,
+					w+1, std::ref(applied[w])));
+		const bool passed = reader(reads);
+		stop.store(true);
+		for (unsigned w=0; w<writers; ++w)
+			threads[w].join();
+		if (!passed)
+			return false;
+		// Check every element against all applies, once quiescent
+		std::vector<RESULT_T> values(size, 0);
+		for (unsigned w=0; w<writers; ++w) {
+			for (std::size_t k=0; k<applied[w].size(); ++k) {
+				for (INDEX_T i=applied[w][k].first; i<applied[w][k].second; ++i)
+					++values[i];
+			}
+		}
+		for (INDEX_T i=0; i<size; ++i) {
+			if (ash[i] != values[i] || ash.get_relaxed(i) != values[i]) {
+				std::cout << "FAILURE - [" << i << ']' << std::endl;
+				std::cout << "alg: \t" << ash[i] << std::endl;
+				std::cout << "true:\t" << values[i] << std::endl;
+				return false;
+			}
+		}
+		std::cout << "Test passed." << std::endl;
+		return true;
+	}
+};
+
+int main() {
+	return test_gutter_apply_concurrent<long>(1000).stress_test(4, 1000000) ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#include "gutter_apply.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+template <typename RESULT_T>
+class test_gutter_apply_sum {
+private:
+	typedef std::size_t INDEX_T;
+
+	const add<RESULT_T> functor;
+	gutter_apply<RESULT_T,add<RESULT_T> > ash;
+	std::vector<RESULT_T> values;
+	const INDEX_T size;
+public:
+	test_gutter_apply_sum(INDEX_T length)
+	: functor(), ash(length,functor), values(length, functor()), size(length) {}
+
+	void test_add_to_range(INDEX_T index1, INDEX_T index2, RESULT_T delta) {
+		ash.apply(index1, index2, delta);
+		for (INDEX_T i=index1;i<index2;++i)
+			values[i]=functor(values[i],delta);
+	}
+	void test_assign(INDEX_T index, RESULT_T x) {
+		ash.assign(index, x);
+		values[index] = functor(values[index], x);
+	}
+	bool test_element(INDEX_T index) {
+		if (ash[index] != values[index]) {
+			std::cout << "FAILURE - [" << index << ']' << std::endl;
+			std::cout << "alg: \t" << ash[index] << std::endl;
+			std::cout << "true:\t" << values[index] << std::endl;
+			return false;
+		}
+		return true;
+	}
+	bool test_copy(INDEX_T index1, INDEX_T index2) {
+		std::vector<RESULT_T> out(index2-index1);
+		ash.copy(index1, index2, out.begin());
+		for (INDEX_T i=index1;i<index2;++i) {
+			if (out[i-index1] != values[i]) {
+				std::cout << "FAILURE - copy [" << index1 << ", " << index2 << ")["
+						<< i << ']' << std::endl;
+				std::cout << "alg: \t" << out[i-index1] << std::endl;
+				std::cout << "true:\t" << values[i] << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		std::cout << "Test suite:\tgutter_apply<T,+> class" << std::endl;
+		std::cout << "\ttarget:\tapply(I,I,T), assign(I,T), operator[], copy(I,I,O), flush() methods" << std::endl;
+		std::cout << "\ttype:\tstress test" << std::endl;
+
+		std::cout << "Beginning Test." << std::endl;
+		for (unsigned round=0; round<rounds; ++round) {
+			// Change values; assign() overwrites whatever was applied before
+			const INDEX_T index1 = rand()%size;
+			const INDEX_T index2 = index1 + rand()%(size-index1+1);
+			test_add_to_range(index1,index2,(rand()%200000)-100000);
+			test_assign(rand()%size,(rand()%200000)-100000);
+			if (round%10 == 0)
+				ash.flush();
+			// Check elements & copies
+			for (INDEX_T i=0;i<size;++i) {
+				if (!test_element(i))
+					return false;
+			}
+			const INDEX_T i1 = rand()%size;
+			if (!test_copy(i1, i1 + rand()%(size-i1+1)))
+				return false;
+		}
+		std::cout << "Test passed." << std::endl;
+		return true;
+	}
+};
+
+int main() {
+	return test_gutter_apply_sum<long>(300).stress_test(200) ? 0 : 1;
+}
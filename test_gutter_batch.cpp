@@ -0,0 +1,125 @@
+#include "gutter_batch.h"
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+// Checks the results of gutter_batch against an array, for queries submitted
+// before updates to the tree (so that they are answered as of drain())
+class test_gutter_batch {
+private:
+	typedef std::size_t INDEX_T;
+
+	std::vector<long> values;
+	gutter_retrieve<long,add<long> > rsh;
+	gutter_apply<long,add<long> > ash;
+	std::vector<long> applied;
+	const INDEX_T size;
+
+	static std::vector<long> random_values(INDEX_T n) {
+		std::vector<long> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = (rand()%200000)-100000;
+		return res;
+	}
+	void update() {
+		const INDEX_T index1 = rand()%size;
+		const INDEX_T index2 = index1 + rand()%(size-index1+1);
+		long x = (rand()%200000)-100000;
+		rsh.assign(index1, x);
+		values[index1] = x;
+		ash.apply(index1, index2, x);
+		for (INDEX_T i=index1; i<index2; ++i)
+			applied[i] += x;
+	}
+public:
+	test_gutter_batch(INDEX_T length)
+	: values(random_values(length)), rsh(values.begin(), values.end()), ash(length),
+	applied(length, 0), size(length) {}
+
+	bool test_ranges(unsigned k, unsigned lanes) {
+		gutter_batch<gutter_retrieve<long,add<long> > > batch(rsh, lanes);
+		std::vector<std::pair<INDEX_T,INDEX_T> > ranges;
+		for (unsigned j=0; j<k; ++j) {
+			// Repeats a range now and then (see accumulate_batch)
+			if (j > 0 && rand()%4 == 0) {
+				ranges.push_back(ranges.back());
+			} else {
+				const INDEX_T index1 = rand()%(size+1);
+				ranges.push_back(std::make_pair(index1, index1 + rand()%(size-index1+1)));
+			}
+			batch.submit(ranges.back().first, ranges.back().second);
+			if (rand()%8 == 0)
+				update();
+		}
+		const INDEX_T submitted = batch.size();
+		std::vector<long> out;
+		batch.drain(std::back_inserter(out));
+		if (submitted != k || batch.size() != 0 || out.size() != k) {
+			std::cout << "FAILURE - " << out.size() << " of " << k << " ranges drained" << std::endl;
+			return false;
+		}
+		for (unsigned j=0; j<k; ++j) {
+			long tmp2 = 0;
+			for (INDEX_T i=ranges[j].first; i<ranges[j].second; ++i)
+				tmp2 += values[i];
+			if (out[j] != tmp2) {
+				std::cout << "FAILURE - [" << ranges[j].first << ", " << ranges[j].second
+						<< "), " << lanes << " lanes" << std::endl;
+				std::cout << "alg: \t" << out[j] << std::endl;
+				std::cout << "true:\t" << tmp2 << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+	bool test_elements(unsigned k, unsigned lanes) {
+		gutter_batch<gutter_apply<long,add<long> > > batch(ash, lanes);
+		std::vector<INDEX_T> leaves;
+		for (unsigned j=0; j<k; ++j) {
+			leaves.push_back(rand()%size);
+			batch.submit(leaves.back());
+			if (rand()%8 == 0)
+				update();
+		}
+		std::vector<long> out(k);
+		if (batch.drain(out.begin()) != out.end()) {
+			std::cout << "FAILURE - drain() of " << k << " elements" << std::endl;
+			return false;
+		}
+		for (unsigned j=0; j<k; ++j) {
+			if (out[j] != applied[leaves[j]]) {
+				std::cout << "FAILURE - [" << leaves[j] << "], " << lanes << " lanes" << std::endl;
+				std::cout << "alg: \t" << out[j] << std::endl;
+				std::cout << "true:\t" << applied[leaves[j]] << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		const unsigned lanes[] = {1, 3, 8, 16};
+		for (unsigned round=0; round<rounds; ++round) {
+			const unsigned k = rand()%40;
+			if (!test_ranges(k, lanes[round%4]) || !test_elements(k, lanes[round%4]))
+				return false;
+		}
+		return true;
+	}
+};
+
+int main() {
+	std::cout << "Test suite:\tgutter_batch<gutter_retrieve/gutter_apply<T,+> > class" << std::endl;
+	std::cout << "\ttarget:\tsubmit(Q), drain(I) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 7, 64, 100, 1000};
+	for (unsigned s=0; s<6; ++s) {
+		if (!test_gutter_batch(sizes[s]).stress_test(40))
+			return 1;
+	}
+	std::cout << "Test passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,193 @@
+#include "gutter_apply.h"
+#include "gutter_retrieve.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Counts the results combined in place, across the functors below
+static unsigned long combined_in_place = 0;
+
+// A histogram of 4 bins backed by heap storage, added bin by bin (empty for the
+// identity element)
+typedef std::vector<long> histogram;
+std::ostream& operator<<(std::ostream& os, const histogram& h) {
+	os << '{';
+	for (std::size_t b=0; b<h.size(); ++b)
+		os << (b ? ", " : "") << h[b];
+	return os << '}';
+}
+struct add_bins {
+	histogram operator()() const {
+		return histogram();
+	}
+	histogram operator()(const histogram& x1, const histogram& x2) const {
+		histogram res = x1;
+		combine(res, x2);
+		return res;
+	}
+	void combine_into(histogram& acc, const histogram& x) const {
+		++combined_in_place;
+		combine(acc, x);
+	}
+	static void combine(histogram& acc, const histogram& x) {
+		if (acc.size() < x.size())
+			acc.resize(x.size(), 0);
+		for (std::size_t b=0; b<x.size(); ++b)
+			acc[b] += x[b];
+	}
+};
+template <>
+struct gutter_is_commutative<add_bins> : std::true_type {};
+
+// Concatenation: a non-commutative functor over results with heap storage, so
+// that combining in place must keep the elements in order
+struct concat {
+	std::string operator()() const {
+		return std::string();
+	}
+	std::string operator()(const std::string& x1, const std::string& x2) const {
+		return x1 + x2;
+	}
+	void combine_into(std::string& acc, const std::string& x) const {
+		++combined_in_place;
+		acc += x;
+	}
+};
+
+// Checks trees over functors that combine in place, against a fold of an array
+// through op()
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T>
+class test_gutter_combine {
+private:
+	typedef std::size_t INDEX_T;
+	typedef RESULT_T (*random_t)();
+
+	const FUNCTOR_T functor;
+	const random_t random_value;
+	std::vector<RESULT_T> values;
+	gutter_retrieve<RESULT_T,FUNCTOR_T,LAYOUT_T> rsh;
+	gutter_apply<RESULT_T,FUNCTOR_T,LAYOUT_T> ash;
+	std::vector<RESULT_T> applied;
+	const INDEX_T size;
+
+	static std::vector<RESULT_T> random_values(INDEX_T n, random_t random) {
+		std::vector<RESULT_T> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = random();
+		return res;
+	}
+public:
+	test_gutter_combine(INDEX_T length, random_t random)
+	: functor(), random_value(random), values(random_values(length, random)),
+	rsh(values.begin(), values.end()), ash(length), applied(length, functor()),
+	size(length) {}
+
+	void test_assign(INDEX_T index) {
+		RESULT_T x = random_value();
+		rsh.assign(index, x);
+		values[index] = x;
+	}
+	void test_assign_range(INDEX_T index1, INDEX_T index2) {
+		const std::vector<RESULT_T> input = random_values(index2-index1, random_value);
+		rsh.assign(index1, index2, input.begin());
+		std::copy(input.begin(), input.end(), values.begin()+index1);
+	}
+	void test_apply_range(INDEX_T index1, INDEX_T index2) {
+		RESULT_T x = random_value();
+		ash.apply(index1, index2, x);
+		for (INDEX_T i=index1; i<index2; ++i)
+			applied[i] = functor(applied[i], x);
+	}
+	bool test_all() {
+		for (INDEX_T i=0;i<size;++i) {
+			if (ash[i] != applied[i]) {
+				std::cout << "FAILURE - applied [" << i << ']' << std::endl;
+				std::cout << "alg: \t" << ash[i] << std::endl;
+				std::cout << "true:\t" << applied[i] << std::endl;
+				return false;
+			}
+			RESULT_T tmp = functor();
+			for (INDEX_T j=i;j<=size;++j) {
+				if (rsh.accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << rsh.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+				if (j < size)
+					tmp = functor(tmp, values[j]);
+			}
+		}
+		if (rsh.total() != rsh.accumulate(0,size)) {
+			std::cout << "FAILURE - total()" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T index1 = rand()%size;
+			const INDEX_T index2 = index1 + rand()%(size-index1+1);
+			if (rand()%2)
+				test_assign(index1);
+			else
+				test_assign_range(index1, index2);
+			// Applies at different nodes combine in any order
+			if (gutter_is_commutative<FUNCTOR_T>::value)
+				test_apply_range(index1, index2);
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+histogram random_histogram() {
+	histogram res(4);
+	for (std::size_t b=0; b<res.size(); ++b)
+		res[b] = rand()%100;
+	return res;
+}
+std::string random_string() {
+	return std::string(1+rand()%2, char('a'+rand()%26));
+}
+
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T>
+bool test_combine(RESULT_T (*random)(), const char* name, bool counted=true) {
+	std::cout << "Test suite:\tgutter_retrieve/gutter_apply<T," << name << "> classes" << std::endl;
+	std::cout << "\ttarget:\tassign(I,T), assign(I,I,I), apply(I,I,T), operator[], accumulate(I,I) methods, through combine_into" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	combined_in_place = 0;
+	const std::size_t sizes[] = {1, 2, 3, 7, 20, 33};
+	for (unsigned s=0; s<6; ++s) {
+		if (!test_gutter_combine<RESULT_T,FUNCTOR_T,LAYOUT_T>(sizes[s], random).stress_test(20))
+			return false;
+	}
+	if (counted && combined_in_place == 0) {
+		std::cout << "FAILURE - combine_into never called" << std::endl;
+		return false;
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	bool passed = test_combine<histogram,add_bins,gutter_layout_bfs>(
+			random_histogram, "add_bins,bfs");
+	passed = test_combine<histogram,add_bins,gutter_layout_blocked<3> >(
+			random_histogram, "add_bins,blocked") && passed;
+	passed = test_combine<std::string,concat,gutter_layout_bfs>(
+			random_string, "concat,bfs") && passed;
+	passed = test_combine<std::string,concat,gutter_layout_blocked<3> >(
+			random_string, "concat,blocked") && passed;
+	// add is concatenation over std::string
+	passed = test_combine<std::string,add<std::string>,gutter_layout_bfs>(
+			random_string, "+ (string),bfs", false) && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+#include "gutter_double_buffer.h"
+#include "gutter_lazy.h"
+#include "gutter_retrieve.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Checks move construction/assignment, swap() and clone() of a tree type,
+// supporting assign(I,T) and accumulate(I,I), against arrays
+template <typename TREE_T>
+class test_gutter_moves {
+private:
+	typedef std::size_t INDEX_T;
+
+	const INDEX_T size;
+
+	bool test_equal(TREE_T& tree, const std::vector<long>& values, const char* what) {
+		for (INDEX_T i=0;i<=size;++i) {
+			for (INDEX_T j=i;j<=size;++j) {
+				long tmp = 0;
+				for (INDEX_T k=i;k<j;++k)
+					tmp += values[k];
+				if (tree.accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - " << what << " [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << tree.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+	void test_assign(TREE_T& tree, std::vector<long>& values) {
+		const INDEX_T index = rand()%size;
+		long x = (rand()%200000)-100000;
+		tree.assign(index, x);
+		values[index] = x;
+	}
+public:
+	test_gutter_moves(INDEX_T length) : size(length) {}
+
+	bool stress_test(unsigned rounds, const char* name) {
+		std::cout << "Test suite:\t" << name << " class" << std::endl;
+		std::cout << "\ttarget:\tmove constructor/assignment, swap(), clone() methods" << std::endl;
+		std::cout << "\ttype:\tstress test" << std::endl;
+
+		std::cout << "Beginning Test." << std::endl;
+		TREE_T a(size), b(size);
+		std::vector<long> va(size, 0), vb(size, 0);
+		for (unsigned round=0; round<rounds; ++round) {
+			test_assign(a, va);
+			test_assign(b, vb);
+			// Clones are deep copies
+			TREE_T c = a.clone();
+			std::vector<long> vc = va;
+			test_assign(c, vc);
+			if (!test_equal(a, va, "original") || !test_equal(c, vc, "clone"))
+				return false;
+			// Moves carry the elements along
+			TREE_T d(std::move(c));
+			if (!test_equal(d, vc, "move constructed"))
+				return false;
+			b = std::move(d);
+			vb = vc;
+			a.swap(b);
+			std::swap(va, vb);
+			if (!test_equal(a, va, "swapped") || !test_equal(b, vb, "swapped"))
+				return false;
+		}
+		std::cout << "Test passed." << std::endl;
+		return true;
+	}
+};
+
+// Checks that readers of a double buffer always see a whole published tree,
+// while a writer rewrites and publishes the back tree
+class test_gutter_double_buffer {
+private:
+	typedef std::size_t INDEX_T;
+	typedef gutter_retrieve<long,add<long> > tree_t;
+
+	const INDEX_T size;
+	gutter_double_buffer<tree_t> buffer;
+	std::atomic<long> published;	// = the latest version published
+	std::atomic<bool> stop;
+
+	// = a tree of 'n' elements, each equal to 'version'
+	static tree_t make(INDEX_T n, long version) {
+		std::vector<long> values(n, version);
+		return tree_t(values.begin(), values.end());
+	}
+public:
+	test_gutter_double_buffer(INDEX_T length)
+	: size(length), buffer(make(length, 0)), published(0), stop(false) {}
+
+	// Publishes versions 1, 2, ..., alternating between rewriting the back
+	// tree in place and replacing it
+	void writer(long versions) {
+		for (long v=1; v<=versions; ++v) {
+			if (v%2) {
+				buffer.sync_back();
+				tree_t& back = buffer.back();
+				for (INDEX_T i=0; i<size; ++i) {
+					long x = v;
+					back.assign(i, x);
+				}
+				buffer.publish();
+			} else {
+				buffer.publish(make(size, v));
+			}
+			published.store(v);
+		}
+		stop.store(true);
+	}
+	bool reader() {
+		long last = 0;
+		while (!stop.load()) {
+			const long lo = published.load();
+			const gutter_double_buffer<tree_t>::reader tree = buffer.read();
+			const long total = tree->accumulate(0, size);
+			const long v = (*tree)[0];
+			if (total != v*long(size) || v < lo || v < last) {
+				std::cout << "FAILURE - read total " << total << " of version " << v
+						<< ", after version " << lo << " was published" << std::endl;
+				return false;
+			}
+			last = v;
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned readers, long versions) {
+		std::cout << "Test suite:\tgutter_double_buffer<gutter_retrieve<T,+> > class" << std::endl;
+		std::cout << "\ttarget:\tread(), back(), publish(), sync_back() methods, concurrently" << std::endl;
+		std::cout << "\ttype:\tstress test" << std::endl;
+
+		std::cout << "Beginning Test." << std::endl;
+		std::vector<std::thread> threads;
+		std::vector<char> passed(readers, 0);
+		for (unsigned r=0; r<readers; ++r) {
+			threads.push_back(std::thread([this, &passed, r]() {
+				passed[r] = reader();
+			}));
+		}
+		writer(versions);
+		for (unsigned r=0; r<readers; ++r)
+			threads[r].join();
+		for (unsigned r=0; r<readers; ++r) {
+			if (!passed[r])
+				return false;
+		}
+		const gutter_double_buffer<tree_t>::reader tree = buffer.read();
+		if (tree->accumulate(0, size) != versions*long(size)) {
+			std::cout << "FAILURE - final version not published" << std::endl;
+			return false;
+		}
+		std::cout << "Test passed." << std::endl;
+		return true;
+	}
+};
+
+int main() {
+	bool passed = test_gutter_moves<gutter_retrieve<long,add<long> > >(37)
+			.stress_test(20, "gutter_retrieve<T,+>");
+	passed = test_gutter_moves<gutter_lazy<long,add<long> > >(37)
+			.stress_test(20, "gutter_lazy<T,+,+>") && passed;
+	passed = test_gutter_double_buffer(100).stress_test(3, 2000) && passed;
+	return passed ? 0 : 1;
+}
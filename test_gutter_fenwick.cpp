@@ -0,0 +1,121 @@
+#include "gutter_fenwick.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+template <typename RESULT_T, typename FUNCTOR_T>
+class test_gutter_fenwick {
+private:
+	typedef std::size_t INDEX_T;
+
+	const FUNCTOR_T functor;
+	gutter_fenwick<RESULT_T,FUNCTOR_T> fsh;
+	std::vector<RESULT_T> values;
+	const INDEX_T size;
+public:
+	test_gutter_fenwick(const std::vector<RESULT_T>& source)
+	: functor(), fsh(source.begin(), source.end()), values(source), size(source.size()) {}
+
+	void test_assign(INDEX_T index, RESULT_T x) {
+		fsh.assign(index, x);
+		values[index] = x;
+	}
+	void test_apply(INDEX_T index, RESULT_T x) {
+		fsh.apply(index, x);
+		values[index] = functor(values[index], x);
+	}
+	bool test_range(INDEX_T index1, INDEX_T index2) {
+		const RESULT_T tmp1 = fsh.accumulate(index1,index2);
+		RESULT_T tmp2 = functor();
+		for (INDEX_T i=index1;i<index2;++i)
+			tmp2 = functor(tmp2, values[i]);
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE - [" << index1 << ", " << index2 << ')' << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return true;
+	}
+	bool test_element(INDEX_T index) {
+		if (fsh[index] != values[index]) {
+			std::cout << "FAILURE - [" << index << ']' << std::endl;
+			std::cout << "alg: \t" << fsh[index] << std::endl;
+			std::cout << "true:\t" << values[index] << std::endl;
+			return false;
+		}
+		return true;
+	}
+	bool test_all() {
+		for (INDEX_T i=0;i<size;++i) {
+			if (!test_element(i))
+				return false;
+			for (INDEX_T j=i;j<=size;++j) {
+				if (!test_range(i,j))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// Runs 'rounds' rounds of one assign of a value from 'assigned' or apply of
+	// a value from 'applied', and a check of every element and range
+	bool stress_test(unsigned rounds, const std::vector<RESULT_T>& assigned,
+			const std::vector<RESULT_T>& applied, const char* name) {
+		std::cout << "Test suite:\tgutter_fenwick<T," << name << "> class" << std::endl;
+		std::cout << "\ttarget:\tassign(I,T), apply(I,T), operator[], accumulate(I,I) methods" << std::endl;
+		std::cout << "\ttype:\tstress test" << std::endl;
+
+		std::cout << "Beginning Test." << std::endl;
+		if (!test_all())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T index = rand()%size;
+			if (rand()%2)
+				test_assign(index, assigned[rand()%assigned.size()]);
+			else
+				test_apply(index, applied[rand()%applied.size()]);
+			if (!test_all())
+				return false;
+		}
+		std::cout << "Test passed." << std::endl;
+		return true;
+	}
+};
+
+int main() {
+	bool passed = true;
+	{
+		std::vector<long> source(200);
+		for (std::size_t i=0; i<source.size(); ++i)
+			source[i] = (rand()%200000)-100000;
+		std::vector<long> choices;
+		for (int k=0; k<64; ++k)
+			choices.push_back((rand()%200000)-100000);
+		passed = test_gutter_fenwick<long,add<long> >(source).stress_test(
+				100, choices, choices, "+") && passed;
+	}
+	{
+		// Re-assigning a 0, then a non-zero value
+		const long values[] = {2, 0, 3, 4};
+		std::vector<long> source(values, values+4);
+		test_gutter_fenwick<long,add<long> > tested(source);
+		tested.test_assign(1, 0);
+		tested.test_assign(1, 7);
+		tested.test_assign(0, 0);
+		if (!tested.test_all()) {
+			std::cout << "FAILURE - re-assigning 0 over {2,0,3,4}" << std::endl;
+			passed = false;
+		}
+	}
+	{
+		// Mostly zeros, assigned 0 and then non-zero values again
+		std::vector<long> source(50, 0);
+		source[7] = 5;
+		const long values[] = {0, 0, 0, 1, -1, 7};
+		std::vector<long> assigned(values, values+6), applied(values, values+6);
+		passed = test_gutter_fenwick<long,add<long> >(source).stress_test(
+				200, assigned, applied, "+ (zeros)") && passed;
+	}
+	return passed ? 0 : 1;
+}
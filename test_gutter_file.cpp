@@ -0,0 +1,156 @@
+#include "gutter_apply.h"
+#include "gutter_retrieve.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+static const char* const path = "test_gutter_file.tmp";
+
+// Checks trees served out of a file written by save() against an array
+template <typename LAYOUT_T>
+class test_gutter_file {
+private:
+	typedef std::size_t INDEX_T;
+	typedef gutter_retrieve<long,add<long>,LAYOUT_T> retrieve_t;
+	typedef gutter_apply<long,add<long>,LAYOUT_T> apply_t;
+
+	std::vector<long> values;
+	const INDEX_T size;
+
+	static std::vector<long> random_values(INDEX_T n) {
+		std::vector<long> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = (rand()%200000)-100000;
+		return res;
+	}
+public:
+	test_gutter_file(INDEX_T length)
+	: values(random_values(length)), size(length) {}
+
+	bool test_retrieve(bool verify) {
+		retrieve_t rsh(values.begin(), values.end());
+		// Apply to a few elements after building, so that the saved tree is
+		// not just the one its constructor built
+		for (unsigned k=0; k<4; ++k) {
+			const INDEX_T index = rand()%size;
+			long x = (rand()%200000)-100000;
+			rsh.apply(index, x);
+			values[index] += x;
+		}
+		if (!rsh.save(path)) {
+			std::cout << "FAILURE - save(" << path << ')' << std::endl;
+			return false;
+		}
+		const gutter_mapped<retrieve_t> mapped = retrieve_t::open_mmap(path, verify);
+		if (!mapped || mapped->size() != size) {
+			std::cout << "FAILURE - open_mmap(" << path << ')' << std::endl;
+			return false;
+		}
+		for (INDEX_T i=0;i<size;++i) {
+			long tmp = 0;
+			for (INDEX_T j=i;j<=size;++j) {
+				if (mapped->accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << mapped->accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+				if (j < size)
+					tmp += values[j];
+			}
+		}
+		return true;
+	}
+	bool test_apply(bool verify) {
+		apply_t ash(size);
+		std::vector<long> applied(size, 0);
+		for (unsigned k=0; k<16; ++k) {
+			const INDEX_T index1 = rand()%size;
+			const INDEX_T index2 = index1 + rand()%(size-index1+1);
+			long x = (rand()%200000)-100000;
+			ash.apply(index1, index2, x);
+			for (INDEX_T i=index1; i<index2; ++i)
+				applied[i] += x;
+		}
+		if (!ash.save(path)) {
+			std::cout << "FAILURE - save(" << path << ')' << std::endl;
+			return false;
+		}
+		const gutter_mapped<apply_t> mapped = apply_t::open_mmap(path, verify);
+		if (!mapped || mapped->size() != size) {
+			std::cout << "FAILURE - open_mmap(" << path << ')' << std::endl;
+			return false;
+		}
+		for (INDEX_T i=0;i<size;++i) {
+			if ((*mapped)[i] != applied[i]) {
+				std::cout << "FAILURE - [" << i << ']' << std::endl;
+				std::cout << "alg: \t" << (*mapped)[i] << std::endl;
+				std::cout << "true:\t" << applied[i] << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+	// Checks that files of another tree type, or corrupted ones, do not open
+	bool test_rejected() {
+		retrieve_t rsh(values.begin(), values.end());
+		if (!rsh.save(path))
+			return false;
+		if (gutter_retrieve<long,mult<long>,LAYOUT_T>::open_mmap(path)
+				|| gutter_retrieve<int,add<int>,LAYOUT_T>::open_mmap(path)
+				|| gutter_mapped<retrieve_t>(path, false, size+1)) {
+			std::cout << "FAILURE - opened as the wrong tree type" << std::endl;
+			return false;
+		}
+		// Flip a byte of the first element
+		std::FILE* file = std::fopen(path, "r+b");
+		if (!file)
+			return false;
+		std::fseek(file, sizeof(gutter_file_header), SEEK_SET);
+		const int byte = std::fgetc(file);
+		std::fseek(file, sizeof(gutter_file_header), SEEK_SET);
+		std::fputc(byte ^ 0xff, file);
+		std::fclose(file);
+		if (retrieve_t::open_mmap(path, true) || !retrieve_t::open_mmap(path, false)) {
+			std::cout << "FAILURE - checksum not verified" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		for (unsigned round=0; round<rounds; ++round) {
+			if (!test_retrieve(round%2) || !test_apply(round%2))
+				return false;
+		}
+		return test_rejected();
+	}
+};
+
+template <typename LAYOUT_T>
+bool test_file(const char* name) {
+	std::cout << "Test suite:\tgutter_retrieve/gutter_apply<T,+," << name << "> classes" << std::endl;
+	std::cout << "\ttarget:\tsave(P), open_mmap(P,B) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 7, 64, 100, 333};
+	for (unsigned s=0; s<6; ++s) {
+		if (!test_gutter_file<LAYOUT_T>(sizes[s]).stress_test(4))
+			return false;
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	bool passed = test_file<gutter_layout_bfs>("bfs");
+	passed = test_file<gutter_layout_blocked<3> >("blocked") && passed;
+	if (gutter_retrieve<long,add<long> >::open_mmap("test_gutter_file.missing")) {
+		std::cout << "FAILURE - opened a missing file" << std::endl;
+		passed = false;
+	}
+	std::remove(path);
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#include "gutter_apply.h"
+#include "gutter_retrieve.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+template <typename LAYOUT_T>
+class test_gutter_layout {
+private:
+	typedef std::size_t INDEX_T;
+
+	const add<long> functor;
+	gutter_retrieve<long,add<long>,LAYOUT_T> rsh;
+	gutter_apply<long,add<long>,LAYOUT_T> ash;
+	std::vector<long> values;
+	const INDEX_T size;
+public:
+	test_gutter_layout(INDEX_T length)
+	: functor(), rsh(length,functor), ash(length,functor), values(length, 0), size(length) {}
+
+	// Checks that the nodes of the heap are placed at distinct positions
+	// within the storage
+	bool test_positions() {
+		const LAYOUT_T layout(size);
+		std::vector<bool> used(layout.storage_size(), false);
+		for (INDEX_T i=1; i<2*size; ++i) {
+			const INDEX_T p = layout.position(i);
+			if (p >= used.size() || used[p]) {
+				std::cout << "FAILURE - node " << i << " of " << size
+						<< " at position " << p << std::endl;
+				return false;
+			}
+			used[p] = true;
+		}
+		return true;
+	}
+	// Adds 'delta' to element 'index1' of the retrieve tree, and to the
+	// elements [index1,index2) of the apply tree
+	void test_add(INDEX_T index1, INDEX_T index2, long delta) {
+		rsh.apply(index1, delta);
+		values[index1] += delta;
+		ash.apply(index1, index2, delta);
+	}
+	bool test_all(const std::vector<long>& applied) {
+		for (INDEX_T i=0;i<size;++i) {
+			if (ash[i] != applied[i]) {
+				std::cout << "FAILURE - apply [" << i << ']' << std::endl;
+				return false;
+			}
+			for (INDEX_T j=i;j<=size;++j) {
+				long tmp = 0;
+				for (INDEX_T k=i;k<j;++k)
+					tmp += values[k];
+				if (rsh.accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << rsh.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_positions())
+			return false;
+		std::vector<long> applied(size, 0);
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T index1 = rand()%size;
+			const INDEX_T index2 = index1 + rand()%(size-index1+1);
+			const long delta = (rand()%200000)-100000;
+			test_add(index1, index2, delta);
+			for (INDEX_T i=index1; i<index2; ++i)
+				applied[i] += delta;
+			if (!test_all(applied))
+				return false;
+		}
+		return true;
+	}
+};
+
+template <typename LAYOUT_T>
+bool test_layout(const char* name) {
+	std::cout << "Test suite:\t" << name << " layout" << std::endl;
+	std::cout << "\ttarget:\tposition(I), storage_size() methods, through gutter_retrieve/gutter_apply" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	for (std::size_t n=1; n<=70; ++n) {
+		if (!test_gutter_layout<LAYOUT_T>(n).stress_test(5))
+			return false;
+	}
+	if (!test_gutter_layout<LAYOUT_T>(300).stress_test(3))
+		return false;
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	bool passed = test_layout<gutter_layout_bfs>("gutter_layout_bfs");
+	passed = test_layout<gutter_layout_blocked<1> >("gutter_layout_blocked<1>") && passed;
+	passed = test_layout<gutter_layout_blocked<2> >("gutter_layout_blocked<2>") && passed;
+	passed = test_layout<gutter_layout_blocked<3> >("gutter_layout_blocked<3>") && passed;
+	passed = test_layout<gutter_layout_blocked<4> >("gutter_layout_blocked<4>") && passed;
+	return passed ? 0 : 1;
+}
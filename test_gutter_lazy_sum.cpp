@@ -0,0 +1,195 @@
+
+#include "gutter_lazy.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+template <typename RESULT_T>
+class test_gutter_lazy_sum {
+private:
+	typedef std::size_t INDEX_T;
+
+	const add<RESULT_T> functor;
+	gutter_lazy<RESULT_T,add<RESULT_T> > lsh;
+	RESULT_T *values;
+	const INDEX_T size;
+public:
+	test_gutter_lazy_sum(INDEX_T length)
+	: functor(), lsh(length,functor), values(new RESULT_T[length]), size(length) {
+		for (INDEX_T i=0;i<size;++i) {
+			values[i] = functor();
+		}
+	}
+	~test_gutter_lazy_sum() {
+		delete[] values;
+	}
+
+	void test_add_to_range(INDEX_T index1, INDEX_T index2, RESULT_T delta,
+			bool should_print_results=false) {
+		if (should_print_results)
+			std::cout << '[' << index1 << ", " << index2 << ") <+ " << delta << std::endl;
+		lsh.apply(index1, index2, delta);
+		for (INDEX_T i=index1;i<index2;++i)
+			values[i]=functor(values[i],delta);
+	}
+	bool test_sum_range(INDEX_T index1, INDEX_T index2, bool should_print_results=false) {
+		if (should_print_results)
+			std::cout << '[' << index1 << ", " << index2 << ')' << std::endl;
+		RESULT_T tmp1 = lsh.accumulate(index1,index2);
+		RESULT_T tmp2=0;
+		for (INDEX_T i=index1;i<index2;++i)
+			tmp2+=values[i];
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE";
+			if (!should_print_results)
+				std::cout << " - [" << index1 << ", " << index2 << ')' << std::endl;
+			else
+				std::cout << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+
+		} else if (should_print_results) {
+			std::cout << "alg = true = " << tmp1 << std::endl;
+		}
+		return tmp1==tmp2;
+	}
+	bool test_element(INDEX_T index) {
+		if (lsh[index] != values[index]) {
+			std::cout << "FAILURE - [" << index << ']' << std::endl;
+			std::cout << "alg: \t" << lsh[index] << std::endl;
+			std::cout << "true:\t" << values[index] << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		std::cout << "Test suite:\tgutter_lazy<T,+,+> class" << std::endl;
+		std::cout << "\ttarget:\tapply(I,I,T), accumulate(I,I), operator[] methods" << std::endl;
+		std::cout << "\ttype:\tstress test" << std::endl;
+
+		std::cout << "Beginning Test." << std::endl;
+		for (unsigned round=0; round<rounds; ++round) {
+			// Change values
+			const INDEX_T index1 = rand()%size;
+			const INDEX_T index2 = index1 + rand()%(size-index1+1);
+			test_add_to_range(index1,index2,(rand()%200000)-100000);
+			// Check elements & sums
+			for (INDEX_T i=0;i<size;++i) {
+				if (!test_element(i))
+					return false;
+			}
+			for (INDEX_T i=0;i<=index1;++i) {
+				for (INDEX_T j=index2;j<=size;++j) {
+					if (!test_sum_range(i,j)) {
+						return false;
+					}
+				}
+			}
+		}
+		std::cout << "Test passed." << std::endl;
+		return true;
+	}
+};
+
+// An element that may be absent; combined by keeping the rightmost present
+// element (a non-commutative combine), and shifted by adding to its value
+struct maybe_long {
+	long value;
+	bool present;
+	bool operator!=(const maybe_long& other) const {
+		return present != other.present || (present && value != other.value);
+	}
+};
+std::ostream& operator<<(std::ostream& os, const maybe_long& x) {
+	return x.present ? (os << x.value) : (os << "(none)");
+}
+struct rightmost {
+	maybe_long operator()() const {
+		const maybe_long none = {0, false};
+		return none;
+	}
+	maybe_long operator()(const maybe_long& x1, const maybe_long& x2) const {
+		return x2.present ? x2 : x1;
+	}
+};
+struct shift {
+	maybe_long operator()() const {
+		const maybe_long none = {0, false};
+		return none;
+	}
+	maybe_long operator()(const maybe_long& x, const maybe_long& delta) const {
+		const maybe_long res = {x.value+delta.value, x.present};
+		return res;
+	}
+};
+
+class test_gutter_lazy_rightmost {
+private:
+	typedef std::size_t INDEX_T;
+
+	const rightmost functor;
+	const shift update;
+	std::vector<maybe_long> values;
+	gutter_lazy<maybe_long,rightmost,shift> lrh;
+	const INDEX_T size;
+public:
+	test_gutter_lazy_rightmost(const std::vector<maybe_long>& source)
+	: functor(), update(), values(source), lrh(source.begin(), source.end()),
+	size(source.size()) {}
+
+	void test_shift_range(INDEX_T index1, INDEX_T index2, long delta) {
+		const maybe_long x = {delta, false};
+		lrh.apply(index1, index2, x);
+		for (INDEX_T i=index1;i<index2;++i)
+			values[i]=update(values[i],x);
+	}
+	bool test_range(INDEX_T index1, INDEX_T index2) {
+		const maybe_long tmp1 = lrh.accumulate(index1,index2);
+		maybe_long tmp2 = functor();
+		for (INDEX_T i=index1;i<index2;++i)
+			tmp2 = functor(tmp2, values[i]);
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE - [" << index1 << ", " << index2 << ')' << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		std::cout << "Test suite:\tgutter_lazy<T,rightmost,shift> class" << std::endl;
+		std::cout << "\ttarget:\tapply(I,I,T), accumulate(I,I) methods" << std::endl;
+		std::cout << "\ttype:\tstress test" << std::endl;
+
+		std::cout << "Beginning Test." << std::endl;
+		for (unsigned round=0; round<rounds; ++round) {
+			// Change values
+			const INDEX_T index1 = rand()%size;
+			const INDEX_T index2 = index1 + rand()%(size-index1+1);
+			test_shift_range(index1,index2,(rand()%200000)-100000);
+			// Check all ranges
+			for (INDEX_T i=0;i<size;++i) {
+				for (INDEX_T j=i;j<=size;++j) {
+					if (!test_range(i,j))
+						return false;
+				}
+			}
+		}
+		std::cout << "Test passed." << std::endl;
+		return true;
+	}
+};
+
+int main() {
+	bool passed = test_gutter_lazy_sum<long>(300).stress_test(100);
+	// A third of the elements are absent
+	std::vector<maybe_long> source(100);
+	for (std::size_t i=0; i<source.size(); ++i) {
+		source[i].value = (rand()%200000)-100000;
+		source[i].present = (rand()%3 != 0);
+	}
+	passed = test_gutter_lazy_rightmost(source).stress_test(100) && passed;
+	return passed ? 0 : 1;
+}
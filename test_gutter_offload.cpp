@@ -0,0 +1,103 @@
+#include "gutter_offload.h"
+#include "gutter_retrieve.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Checks gutter_offload, copied off a gutter_retrieve, against an array
+template <typename FUNCTOR_T, typename LAYOUT_T>
+class test_gutter_offload {
+private:
+	typedef std::size_t INDEX_T;
+
+	const FUNCTOR_T functor;
+	std::vector<long> values;
+	const INDEX_T size;
+
+	static std::vector<long> random_values(INDEX_T n) {
+		std::vector<long> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = (rand()%200000)-100000;
+		return res;
+	}
+	long expected(INDEX_T index1, INDEX_T index2) const {
+		long res = functor();
+		for (INDEX_T i=index1; i<index2; ++i)
+			res = functor(res, values[i]);
+		return res;
+	}
+public:
+	test_gutter_offload(INDEX_T length)
+	: functor(), values(random_values(length)), size(length) {}
+
+	bool stress_test(unsigned batches) {
+		gutter_retrieve<long,FUNCTOR_T,LAYOUT_T> rsh(values.begin(), values.end());
+		// Updates after building, so that the copied nodes are not just those
+		// of the constructor
+		for (unsigned k=0; k<8; ++k) {
+			const INDEX_T index = rand()%size;
+			long x = (rand()%200000)-100000;
+			rsh.assign(index, x);
+			values[index] = x;
+		}
+		const gutter_offload<long,FUNCTOR_T> osh(rsh);
+		if (osh.size() != size) {
+			std::cout << "FAILURE - size " << osh.size() << " of " << size << std::endl;
+			return false;
+		}
+		for (INDEX_T i=0;i<size;++i) {
+			for (INDEX_T j=i;j<=size;++j) {
+				if (osh.accumulate(i,j) != expected(i,j)) {
+					std::cout << "FAILURE - [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << osh.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << expected(i,j) << std::endl;
+					return false;
+				}
+			}
+		}
+		for (unsigned b=0; b<batches; ++b) {
+			std::vector<std::pair<INDEX_T,INDEX_T> > ranges(rand()%100);
+			for (std::size_t j=0; j<ranges.size(); ++j) {
+				const INDEX_T index1 = rand()%(size+1);
+				ranges[j] = std::make_pair(index1, index1 + rand()%(size-index1+1));
+			}
+			std::vector<long> out(ranges.size());
+			osh.accumulate_batch(ranges.data(), ranges.size(), out.data());
+			for (std::size_t j=0; j<ranges.size(); ++j) {
+				const long tmp2 = expected(ranges[j].first, ranges[j].second);
+				if (out[j] != tmp2) {
+					std::cout << "FAILURE - batch [" << ranges[j].first << ", "
+							<< ranges[j].second << ')' << std::endl;
+					std::cout << "alg: \t" << out[j] << std::endl;
+					std::cout << "true:\t" << tmp2 << std::endl;
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+};
+
+template <typename FUNCTOR_T, typename LAYOUT_T>
+bool test_offload(const char* name) {
+	std::cout << "Test suite:\tgutter_offload<T," << name << "> class" << std::endl;
+	std::cout << "\ttarget:\tconstructor(G), accumulate(I,I), accumulate_batch(R,K,O) methods"
+			<< (gutter_offload<long,FUNCTOR_T>::offloaded() ? ", on a device" : "") << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 3, 7, 64, 100, 333};
+	for (unsigned s=0; s<7; ++s) {
+		if (!test_gutter_offload<FUNCTOR_T,LAYOUT_T>(sizes[s]).stress_test(10))
+			return false;
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	bool passed = test_offload<add<long>,gutter_layout_bfs>("+,bfs");
+	passed = test_offload<add<long>,gutter_layout_blocked<3> >("+,blocked") && passed;
+	passed = test_offload<min<long>,gutter_layout_bfs>("min,bfs") && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include "gutter_retrieve_2d.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+template <typename FUNCTOR_T>
+class test_gutter_retrieve_2d {
+private:
+	typedef std::size_t INDEX_T;
+
+	const FUNCTOR_T functor;
+	const INDEX_T rows, cols;
+	std::vector<long> values;	// row-major
+	gutter_retrieve_2d<long,FUNCTOR_T> rsh;
+
+	static std::vector<long> random_values(INDEX_T n) {
+		std::vector<long> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = (rand()%200000)-100000;
+		return res;
+	}
+public:
+	test_gutter_retrieve_2d(INDEX_T n1, INDEX_T n2)
+	: functor(), rows(n1), cols(n2), values(random_values(n1*n2)),
+	rsh(n1, n2, values.begin()) {}
+
+	void test_assign(INDEX_T i, INDEX_T j, long x) {
+		rsh.assign(i, j, x);
+		values[i*cols+j] = x;
+	}
+	void test_apply(INDEX_T i, INDEX_T j, long x) {
+		rsh.apply(i, j, x);
+		values[i*cols+j] = functor(values[i*cols+j], x);
+	}
+	void test_rebuild() {
+		values = random_values(rows*cols);
+		rsh.rebuild(values.begin(), values.end());
+	}
+	bool test_rectangle(INDEX_T i1, INDEX_T i2, INDEX_T j1, INDEX_T j2) {
+		const long tmp1 = rsh.accumulate(i1,i2,j1,j2);
+		long tmp2 = functor();
+		for (INDEX_T i=i1;i<i2;++i) {
+			for (INDEX_T j=j1;j<j2;++j)
+				tmp2 = functor(tmp2, values[i*cols+j]);
+		}
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE - [" << i1 << ", " << i2 << ")x["
+					<< j1 << ", " << j2 << ')' << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return true;
+	}
+	// Checks every element, and every rectangle (or a sample of them, if there
+	// are many)
+	bool test_all() {
+		for (INDEX_T i=0;i<rows;++i) {
+			for (INDEX_T j=0;j<cols;++j) {
+				if (rsh(i,j) != values[i*cols+j]) {
+					std::cout << "FAILURE - (" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << rsh(i,j) << std::endl;
+					std::cout << "true:\t" << values[i*cols+j] << std::endl;
+					return false;
+				}
+			}
+		}
+		if (rows*cols <= 64) {
+			for (INDEX_T i1=0;i1<=rows;++i1) {
+				for (INDEX_T i2=i1;i2<=rows;++i2) {
+					for (INDEX_T j1=0;j1<=cols;++j1) {
+						for (INDEX_T j2=j1;j2<=cols;++j2) {
+							if (!test_rectangle(i1,i2,j1,j2))
+								return false;
+						}
+					}
+				}
+			}
+			return true;
+		}
+		for (unsigned k=0; k<500; ++k) {
+			const INDEX_T i1 = rand()%(rows+1), j1 = rand()%(cols+1);
+			if (!test_rectangle(i1, i1+rand()%(rows-i1+1), j1, j1+rand()%(cols-j1+1)))
+				return false;
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T i = rand()%rows, j = rand()%cols;
+			switch (rand()%5) {
+			case 0:
+				test_rebuild();
+				break;
+			case 1:
+			case 2:
+				test_assign(i, j, (rand()%200000)-100000);
+				break;
+			default:
+				test_apply(i, j, (rand()%200000)-100000);
+			}
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+template <typename FUNCTOR_T>
+bool test_2d(const char* name) {
+	std::cout << "Test suite:\tgutter_retrieve_2d<T," << name << "> class" << std::endl;
+	std::cout << "\ttarget:\tassign(I,I,T), apply(I,I,T), rebuild(I,I), operator(), accumulate(I,I,I,I) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 3, 5, 8, 13, 40};
+	for (unsigned s1=0; s1<7; ++s1) {
+		for (unsigned s2=0; s2<7; ++s2) {
+			if (!test_gutter_retrieve_2d<FUNCTOR_T>(sizes[s1], sizes[s2]).stress_test(20))
+				return false;
+		}
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	bool passed = test_2d<add<long> >("+");
+	passed = test_2d<max<long> >("max") && passed;
+	return passed ? 0 : 1;
+}
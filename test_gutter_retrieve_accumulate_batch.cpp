@@ -0,0 +1,79 @@
+#include "gutter_retrieve.h"
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+template <typename RESULT_T, typename FUNCTOR_T>
+class test_gutter_retrieve_accumulate_batch {
+private:
+	typedef std::size_t INDEX_T;
+
+	const FUNCTOR_T functor;
+	std::vector<RESULT_T> values;
+	gutter_retrieve<RESULT_T,FUNCTOR_T> rsh;
+	const INDEX_T size;
+public:
+	test_gutter_retrieve_accumulate_batch(const std::vector<RESULT_T>& source)
+	: functor(), values(source), rsh(source.begin(), source.end()), size(source.size()) {}
+
+	// Answers 'k' random ranges (some repeated back to back) 'lanes' at a time
+	bool test_batch(INDEX_T k, unsigned lanes) {
+		std::vector<std::pair<INDEX_T,INDEX_T> > ranges(k);
+		for (INDEX_T j=0; j<k; ++j) {
+			if (j > 0 && rand()%4 == 0) {
+				ranges[j] = ranges[j-1];
+				continue;
+			}
+			ranges[j].first = rand()%(size+1);
+			ranges[j].second = ranges[j].first + rand()%(size-ranges[j].first+1);
+		}
+		std::vector<RESULT_T> out(k);
+		rsh.accumulate_batch(ranges.data(), k, out.data(), lanes);
+		for (INDEX_T j=0; j<k; ++j) {
+			RESULT_T tmp = functor();
+			for (INDEX_T i=ranges[j].first; i<ranges[j].second; ++i)
+				tmp = functor(tmp, values[i]);
+			if (out[j] != tmp) {
+				std::cout << "FAILURE - [" << ranges[j].first << ", " << ranges[j].second
+						<< ") with " << lanes << " lanes" << std::endl;
+				std::cout << "alg: \t" << out[j] << std::endl;
+				std::cout << "true:\t" << tmp << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds, const char* name) {
+		std::cout << "Test suite:\tgutter_retrieve<T," << name << "> class" << std::endl;
+		std::cout << "\ttarget:\taccumulate_batch(P*,I,T*,U) method" << std::endl;
+		std::cout << "\ttype:\tstress test" << std::endl;
+
+		std::cout << "Beginning Test." << std::endl;
+		const unsigned lanes[] = {0, 1, 3, 8, 64};
+		for (unsigned round=0; round<rounds; ++round) {
+			if (!test_batch(rand()%200, lanes[round%5]))
+				return false;
+		}
+		std::cout << "Test passed." << std::endl;
+		return true;
+	}
+};
+
+int main() {
+	bool passed = true;
+	for (std::size_t n=1; n<=300; n=2*n+1) {
+		std::vector<long> sums(n);
+		std::vector<int> mins(n);
+		for (std::size_t i=0; i<n; ++i) {
+			sums[i] = (rand()%200000)-100000;
+			mins[i] = rand()%1000;
+		}
+		passed = test_gutter_retrieve_accumulate_batch<long,add<long> >(sums)
+				.stress_test(20, "+") && passed;
+		passed = test_gutter_retrieve_accumulate_batch<int,min<int> >(mins)
+				.stress_test(20, "min") && passed;
+	}
+	return passed ? 0 : 1;
+}
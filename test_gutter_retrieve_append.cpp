@@ -0,0 +1,97 @@
+#include "gutter_retrieve_append.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+template <typename LAYOUT_T>
+class test_gutter_retrieve_append {
+private:
+	typedef std::size_t INDEX_T;
+
+	gutter_retrieve_append<long,add<long>,LAYOUT_T> ash;
+	std::vector<long> values;
+public:
+	test_gutter_retrieve_append(INDEX_T capacity)
+	: ash(add<long>(), capacity) {}
+
+	void test_push_back(long x) {
+		ash.push_back(x);
+		values.push_back(x);
+	}
+	void test_assign(INDEX_T index, long x) {
+		ash.assign(index, x);
+		values[index] = x;
+	}
+	void test_apply(INDEX_T index, long x) {
+		ash.apply(index, x);
+		values[index] += x;
+	}
+	bool test_all() {
+		const INDEX_T size = values.size();
+		if (ash.size() != size || ash.capacity() < size) {
+			std::cout << "FAILURE - size " << ash.size() << ", capacity "
+					<< ash.capacity() << " for " << size << " elements" << std::endl;
+			return false;
+		}
+		for (INDEX_T i=0;i<size;++i) {
+			if (ash[i] != values[i]) {
+				std::cout << "FAILURE - [" << i << ']' << std::endl;
+				std::cout << "alg: \t" << ash[i] << std::endl;
+				std::cout << "true:\t" << values[i] << std::endl;
+				return false;
+			}
+			long tmp = 0;
+			for (INDEX_T j=i;j<=size;++j) {
+				if (ash.accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << ash.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+				if (j < size)
+					tmp += values[j];
+			}
+		}
+		return true;
+	}
+
+	// Appends 'length' elements, with an assign or apply to a random element
+	// after each append, checking every element and range along the way
+	bool stress_test(INDEX_T length) {
+		if (!test_all())
+			return false;
+		for (INDEX_T i=0; i<length; ++i) {
+			test_push_back((rand()%200000)-100000);
+			const INDEX_T index = rand()%values.size();
+			if (rand()%2)
+				test_assign(index, (rand()%200000)-100000);
+			else
+				test_apply(index, (rand()%200000)-100000);
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+template <typename LAYOUT_T>
+bool test_append(const char* name) {
+	std::cout << "Test suite:\tgutter_retrieve_append<T,+," << name << "> class" << std::endl;
+	std::cout << "\ttarget:\tpush_back(T), assign(I,T), apply(I,T), operator[], accumulate(I,I) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t capacities[] = {1, 2, 3, 64};
+	for (unsigned c=0; c<4; ++c) {
+		if (!test_gutter_retrieve_append<LAYOUT_T>(capacities[c]).stress_test(150))
+			return false;
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	bool passed = test_append<gutter_layout_bfs>("bfs");
+	passed = test_append<gutter_layout_blocked<3> >("blocked") && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+#include "gutter_retrieve.h"
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+template <typename RESULT_T>
+class test_gutter_retrieve_batch {
+private:
+	typedef std::size_t INDEX_T;
+
+	const add<RESULT_T> functor;
+	gutter_retrieve<RESULT_T,add<RESULT_T> > rsh;
+	std::vector<RESULT_T> values;
+	const INDEX_T size;
+public:
+	test_gutter_retrieve_batch(INDEX_T length)
+	: functor(), rsh(length,functor), values(length, functor()), size(length) {}
+
+	// Updates 'k' random elements at once; repeated elements are applied in
+	// turn, or the last one assigned
+	void test_batch(INDEX_T k, bool assign) {
+		std::vector<std::pair<INDEX_T,RESULT_T> > updates(k);
+		for (INDEX_T j=0; j<k; ++j) {
+			updates[j].first = rand()%size;
+			updates[j].second = (rand()%200000)-100000;
+			if (assign)
+				values[updates[j].first] = updates[j].second;
+			else
+				values[updates[j].first] = functor(values[updates[j].first], updates[j].second);
+		}
+		if (assign)
+			rsh.assign_batch(updates.data(), k);
+		else
+			rsh.apply_batch(updates.data(), k);
+	}
+	bool test_sum_range(INDEX_T index1, INDEX_T index2) {
+		const RESULT_T tmp1 = rsh.accumulate(index1,index2);
+		RESULT_T tmp2 = functor();
+		for (INDEX_T i=index1;i<index2;++i)
+			tmp2 = functor(tmp2, values[i]);
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE - [" << index1 << ", " << index2 << ')' << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		std::cout << "Test suite:\tgutter_retrieve<T,+> class" << std::endl;
+		std::cout << "\ttarget:\tapply_batch(P*,I), assign_batch(P*,I) methods" << std::endl;
+		std::cout << "\ttype:\tstress test" << std::endl;
+
+		std::cout << "Beginning Test." << std::endl;
+		for (unsigned round=0; round<rounds; ++round) {
+			// Change values
+			test_batch(rand()%(size/4+1), round%2 != 0);
+			// Check elements & sums
+			for (INDEX_T i=0;i<size;++i) {
+				if (rsh[i] != values[i]) {
+					std::cout << "FAILURE - [" << i << ']' << std::endl;
+					return false;
+				}
+				for (INDEX_T j=i;j<=size;++j) {
+					if (!test_sum_range(i,j))
+						return false;
+				}
+			}
+		}
+		std::cout << "Test passed." << std::endl;
+		return true;
+	}
+};
+
+int main() {
+	bool passed = true;
+	for (std::size_t n=1; n<=17; n+=4)
+		passed = test_gutter_retrieve_batch<long>(n).stress_test(10) && passed;
+	passed = test_gutter_retrieve_batch<long>(200).stress_test(40) && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+#include "gutter_index.h"
+#include "gutter_retrieve_columns.h"
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+typedef std::tuple<long,int,int> row_t;
+std::ostream& operator<<(std::ostream& os, const row_t& x) {
+	return os << '(' << std::get<0>(x) << ", " << std::get<1>(x) << ", " << std::get<2>(x) << ')';
+}
+row_t random_row() {
+	return row_t((rand()%200000)-100000, (rand()%2001)-1000, (rand()%2001)-1000);
+}
+
+// Checks a sum/min/max tree of gutter_retrieve_columns against an array per
+// column
+template <typename LAYOUT_T>
+class test_gutter_retrieve_columns {
+private:
+	typedef std::size_t INDEX_T;
+
+	std::vector<long> sums;
+	std::vector<int> mins, maxs;
+	gutter_retrieve_columns<row_t, std::tuple<add<long>,min<int>,max<int> >, LAYOUT_T> rsh;
+	const INDEX_T size;
+
+	static std::vector<row_t> random_rows(INDEX_T n) {
+		std::vector<row_t> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = random_row();
+		return res;
+	}
+	void set(INDEX_T index, const row_t& x) {
+		sums[index] = std::get<0>(x);
+		mins[index] = std::get<1>(x);
+		maxs[index] = std::get<2>(x);
+	}
+public:
+	test_gutter_retrieve_columns(const std::vector<row_t>& source)
+	: sums(source.size()), mins(source.size()), maxs(source.size()),
+	rsh(source.begin(), source.end()), size(source.size()) {
+		for (INDEX_T i=0; i<size; ++i)
+			set(i, source[i]);
+	}
+
+	void test_assign(INDEX_T index) {
+		const row_t x = random_row();
+		rsh.assign(index, x);
+		set(index, x);
+	}
+	void test_apply(INDEX_T index) {
+		const row_t x = random_row();
+		rsh.apply(index, x);
+		sums[index] += std::get<0>(x);
+		mins[index] = std::min(mins[index], std::get<1>(x));
+		maxs[index] = std::max(maxs[index], std::get<2>(x));
+	}
+	void test_assign_range(INDEX_T index1, INDEX_T index2) {
+		const std::vector<row_t> input = random_rows(index2-index1);
+		rsh.assign(index1, index2, input.begin());
+		for (INDEX_T i=index1; i<index2; ++i)
+			set(i, input[i-index1]);
+	}
+	// = the first element whose leaf wraps around to the row above, or 'size'
+	INDEX_T wrap_point() const {
+		for (INDEX_T i=1; i<size; ++i) {
+			if (gutter_index::index_nth_leaf(i, size) < gutter_index::index_nth_leaf(i-1, size))
+				return i;
+		}
+		return size;
+	}
+	bool test_all() {
+		for (INDEX_T i=0;i<=size;++i) {
+			row_t tmp(0, INT_MAX, INT_MIN);
+			for (INDEX_T j=i;j<=size;++j) {
+				if (rsh.accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << rsh.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+				if (j < size) {
+					if (rsh[j] != row_t(sums[j], mins[j], maxs[j])) {
+						std::cout << "FAILURE - [" << j << ']' << std::endl;
+						std::cout << "alg: \t" << rsh[j] << std::endl;
+						std::cout << "true:\t" << row_t(sums[j], mins[j], maxs[j]) << std::endl;
+						return false;
+					}
+					std::get<0>(tmp) += sums[j];
+					std::get<1>(tmp) = std::min(std::get<1>(tmp), mins[j]);
+					std::get<2>(tmp) = std::max(std::get<2>(tmp), maxs[j]);
+				}
+			}
+		}
+		if (rsh.total() != rsh.accumulate(0,size)) {
+			std::cout << "FAILURE - total()" << std::endl;
+			std::cout << "alg: \t" << rsh.total() << std::endl;
+			std::cout << "true:\t" << rsh.accumulate(0,size) << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all())
+			return false;
+		// Ranges across the leaves that wrap around to the row above
+		const INDEX_T wrap = wrap_point();
+		test_assign_range(wrap-1, size);
+		test_assign_range(0, size);
+		if (wrap < size)
+			test_assign_range(wrap-1, wrap+1);
+		if (!test_all())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T index = rand()%size;
+			switch (round%3) {
+			case 0:
+				test_assign(index);
+				break;
+			case 1:
+				test_apply(index);
+				break;
+			default:
+				test_assign_range(index, index + rand()%(size-index+1));
+			}
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+template <typename LAYOUT_T>
+bool test_columns(const char* name) {
+	std::cout << "Test suite:\tgutter_retrieve_columns<(long,int,int),(+,min,max)," << name << "> class" << std::endl;
+	std::cout << "\ttarget:\tconstructor(I,I), assign(S,T), apply(S,T), assign(I,I,I), accumulate(S,S), total() methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 3, 7, 64, 100, 333};
+	for (unsigned s=0; s<7; ++s) {
+		std::vector<row_t> source(sizes[s]);
+		for (std::size_t i=0; i<source.size(); ++i)
+			source[i] = random_row();
+		if (!test_gutter_retrieve_columns<LAYOUT_T>(source).stress_test(24))
+			return false;
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	bool passed = test_columns<gutter_layout_bfs>("bfs");
+	passed = test_columns<gutter_layout_blocked<3> >("blocked") && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include "gutter_retrieve.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Checks accumulate() of commutative functors over trivially copyable
+// elements (the branch-free walk), including ranges wrapping from the deepest
+// row around to the row above it
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T>
+class test_gutter_retrieve_commutative {
+private:
+	typedef std::size_t INDEX_T;
+
+	const FUNCTOR_T functor;
+	gutter_retrieve<RESULT_T,FUNCTOR_T,LAYOUT_T> rsh;
+	std::vector<RESULT_T> values;
+	const INDEX_T size;
+public:
+	test_gutter_retrieve_commutative(INDEX_T length)
+	: functor(), rsh(length,functor), values(length, functor()), size(length) {}
+
+	void test_assign(INDEX_T index, RESULT_T x) {
+		rsh.assign(index, x);
+		values[index] = x;
+	}
+	bool test_range(INDEX_T index1, INDEX_T index2) {
+		const RESULT_T tmp1 = rsh.accumulate(index1,index2);
+		RESULT_T tmp2 = functor();
+		for (INDEX_T i=index1;i<index2;++i)
+			tmp2 = functor(tmp2, values[i]);
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE - [" << index1 << ", " << index2 << ')' << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		for (unsigned round=0; round<rounds; ++round) {
+			test_assign(rand()%size, RESULT_T((rand()%2001)-1000));
+			for (INDEX_T i=0;i<=size;++i) {
+				for (INDEX_T j=i;j<=size;++j) {
+					if (!test_range(i,j))
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+};
+
+template <typename RESULT_T, typename FUNCTOR_T, typename LAYOUT_T>
+bool test_commutative(const char* name) {
+	std::cout << "Test suite:\tgutter_retrieve<T," << name << "> class" << std::endl;
+	std::cout << "\ttarget:\taccumulate(I,I) method, branch-free walk" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	for (std::size_t n=1; n<=40; ++n) {
+		if (!test_gutter_retrieve_commutative<RESULT_T,FUNCTOR_T,LAYOUT_T>(n).stress_test(n))
+			return false;
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	bool passed = test_commutative<long,add<long>,gutter_layout_bfs>("+");
+	passed = test_commutative<int,min<int>,gutter_layout_bfs>("min") && passed;
+	passed = test_commutative<double,max<double>,gutter_layout_bfs>("max") && passed;
+	passed = test_commutative<long,add<long>,gutter_layout_blocked<3> >("+, blocked") && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include "gutter_retrieve_concurrent.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// The elements [lo,hi), with the sum of their generations: combining requires
+// adjacent spans in order (a non-commutative functor), so that results mixed
+// up or combined out of order are caught
+struct span {
+	std::uint16_t lo, hi;	// both 'none' for the identity, 'broken' if misordered
+	std::int32_t sum;
+};
+static const std::uint16_t none = 0xffff, broken = 0xfffe;
+struct join {
+	span operator()() const {
+		const span identity = {none, none, 0};
+		return identity;
+	}
+	span operator()(const span& x1, const span& x2) const {
+		if (x1.lo == none) return x2;
+		if (x2.lo == none) return x1;
+		const span res = {x1.lo, x2.hi, x1.sum+x2.sum};
+		const span misordered = {broken, broken, 0};
+		return (x1.hi == x2.lo && x1.lo != broken) ? res : misordered;
+	}
+};
+
+// One writer assigns generation 'k' to element (k-1)%n, for k=1,2,..., so that
+// the state of the tree after 'K' assigns is known from 'K' alone; readers
+// check that each result is that of some state between the start and the end
+// of the read
+class test_gutter_retrieve_concurrent {
+private:
+	typedef std::size_t INDEX_T;
+
+	const std::vector<span> source;
+	gutter_retrieve_concurrent<span,join> csh;
+	const INDEX_T size;
+	std::atomic<std::int32_t> done;	// = the number of assigns finished
+	std::atomic<bool> stop;
+
+	static span element(INDEX_T i, std::int32_t generation) {
+		const span res = {std::uint16_t(i), std::uint16_t(i+1), generation};
+		return res;
+	}
+	static std::vector<span> initial(INDEX_T n) {
+		std::vector<span> res;
+		for (INDEX_T i=0; i<n; ++i)
+			res.push_back(element(i, 0));
+		return res;
+	}
+	// = the sum of the generations of [i1,i2), after 'K' assigns
+	std::int64_t expected(INDEX_T i1, INDEX_T i2, std::int32_t K) const {
+		std::int64_t res = 0;
+		for (INDEX_T i=i1; i<i2; ++i) {
+			if (INDEX_T(K) >= i+1)
+				res += std::int32_t(i+1 + size*((K-1-i)/size));
+		}
+		return res;
+	}
+public:
+	test_gutter_retrieve_concurrent(INDEX_T length)
+	: source(initial(length)), csh(source.begin(), source.end()), size(length), done(0), stop(false) {}
+
+	void writer(std::int32_t assigns) {
+		for (std::int32_t k=1; k<=assigns && !stop.load(); ++k) {
+			csh.assign((k-1)%size, element((k-1)%size, k));
+			done.store(k);
+		}
+		stop.store(true);
+	}
+	bool reader(unsigned seed) {
+		while (!stop.load()) {
+			const INDEX_T i1 = rand_r(&seed)%size;
+			const INDEX_T i2 = i1 + 1 + rand_r(&seed)%(size-i1);
+			const std::int32_t before = done.load();
+			const span res = csh.accumulate(i1, i2);
+			// An assign may still be in progress after the last one finished
+			const std::int32_t after = done.load()+1;
+			bool seen = false;
+			for (std::int32_t K=before; K<=after && !seen; ++K)
+				seen = (res.sum == expected(i1, i2, K));
+			if (res.lo != i1 || res.hi != i2 || !seen) {
+				std::cout << "FAILURE - [" << i1 << ", " << i2 << ") between assigns "
+						<< before << " and " << after << std::endl;
+				std::cout << "alg: \t[" << res.lo << ", " << res.hi << "), " << res.sum << std::endl;
+				std::cout << "true:\t" << expected(i1, i2, before) << " to "
+						<< expected(i1, i2, after) << std::endl;
+				stop.store(true);
+				return false;
+			}
+			const span relaxed = csh.accumulate_relaxed(i1, i2);
+			if (relaxed.lo != i1 || relaxed.hi != i2) {
+				std::cout << "FAILURE - relaxed [" << i1 << ", " << i2 << ')' << std::endl;
+				stop.store(true);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned readers, std::int32_t assigns) {
+		std::vector<std::thread> threads;
+		std::vector<char> passed(readers, 0);
+		for (unsigned r=0; r<readers; ++r) {
+			threads.push_back(std::thread([this, r, &passed]() {
+				passed[r] = reader(r+1);
+			}));
+		}
+		writer(assigns);
+		for (unsigned r=0; r<readers; ++r)
+			threads[r].join();
+		for (unsigned r=0; r<readers; ++r) {
+			if (!passed[r])
+				return false;
+		}
+		// Once quiescent, every range is that of the last state
+		for (INDEX_T i=0; i<size; ++i) {
+			for (INDEX_T j=i+1; j<=size; ++j) {
+				const span res = csh.accumulate(i, j);
+				if (res.lo != i || res.hi != j || res.sum != expected(i, j, done.load())) {
+					std::cout << "FAILURE - [" << i << ", " << j << ") when quiescent" << std::endl;
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+};
+
+int main() {
+	std::cout << "Test suite:\tgutter_retrieve_concurrent<T,join> class" << std::endl;
+	std::cout << "\ttarget:\tassign(I,T) method, concurrently with accumulate(I,I)" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 7, 64, 100};
+	for (unsigned s=0; s<5; ++s) {
+		if (!test_gutter_retrieve_concurrent(sizes[s]).stress_test(4, 200000))
+			return 1;
+	}
+	std::cout << "Test passed." << std::endl;
+	return 0;
+}
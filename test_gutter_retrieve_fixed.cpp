@@ -0,0 +1,123 @@
+#include "gutter_retrieve_fixed.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201304
+// Built, updated and queried at compile time
+constexpr long fixed_compile_time() {
+	gutter_retrieve_fixed<long,add<long>,5> fsh{1, 2, 3, 4, 5};
+	fsh.assign(1, 10);
+	fsh.apply(4, 1);
+	return fsh.accumulate(1,5);
+}
+static_assert(fixed_compile_time() == 10+3+4+6, "constexpr gutter_retrieve_fixed");
+#endif
+
+template <std::size_t N>
+class test_gutter_retrieve_fixed {
+private:
+	typedef std::size_t INDEX_T;
+
+	std::vector<long> values;
+	gutter_retrieve_fixed<long,add<long>,N> fsh;
+
+	static std::vector<long> random_values() {
+		std::vector<long> res(N);
+		for (INDEX_T i=0; i<N; ++i)
+			res[i] = (rand()%200000)-100000;
+		return res;
+	}
+public:
+	test_gutter_retrieve_fixed()
+	: values(random_values()), fsh(values.begin(), values.end()) {}
+
+	void test_assign(INDEX_T index, long x) {
+		fsh.assign(index, x);
+		values[index] = x;
+	}
+	void test_apply(INDEX_T index, long x) {
+		fsh.apply(index, x);
+		values[index] += x;
+	}
+	void test_rebuild() {
+		values = random_values();
+		fsh.rebuild(values.begin(), values.end());
+	}
+	bool test_all() {
+		long total = 0;
+		for (INDEX_T i=0;i<N;++i) {
+			if (fsh[i] != values[i]) {
+				std::cout << "FAILURE - [" << i << ']' << std::endl;
+				std::cout << "alg: \t" << fsh[i] << std::endl;
+				std::cout << "true:\t" << values[i] << std::endl;
+				return false;
+			}
+			total += values[i];
+			long tmp = 0;
+			for (INDEX_T j=i;j<=N;++j) {
+				if (fsh.accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << fsh.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+				if (j < N)
+					tmp += values[j];
+			}
+		}
+		if (fsh.total() != total) {
+			std::cout << "FAILURE - total()" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T index = rand()%N;
+			switch (rand()%5) {
+			case 0:
+				test_rebuild();
+				break;
+			case 1:
+			case 2:
+				test_assign(index, (rand()%200000)-100000);
+				break;
+			default:
+				test_apply(index, (rand()%200000)-100000);
+			}
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+int main() {
+	std::cout << "Test suite:\tgutter_retrieve_fixed<T,+,N> class" << std::endl;
+	std::cout << "\ttarget:\tassign(I,T), apply(I,T), rebuild(I,I), operator[], accumulate(I,I) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	bool passed = test_gutter_retrieve_fixed<1>().stress_test(20);
+	passed = passed && test_gutter_retrieve_fixed<2>().stress_test(20);
+	passed = passed && test_gutter_retrieve_fixed<7>().stress_test(50);
+	passed = passed && test_gutter_retrieve_fixed<64>().stress_test(50);
+	passed = passed && test_gutter_retrieve_fixed<100>().stress_test(50);
+	{
+		// Elements past the first 'N' are ignored, and missing ones are the
+		// identity element
+		const gutter_retrieve_fixed<long,add<long>,3> longer{1, 2, 3, 4}, shorter{1, 2};
+		if (longer.total() != 6 || shorter.total() != 3 || shorter[2] != 0) {
+			std::cout << "FAILURE - initializer_list constructor" << std::endl;
+			passed = false;
+		}
+	}
+	if (!passed)
+		return 1;
+	std::cout << "Test passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,102 @@
+#include "gutter_parallel.h"
+#include "gutter_retrieve.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Checks the parallel construction, rebuild and range assignment of
+// gutter_retrieve against an array, with small grains so that every row is
+// split across tasks
+template <typename LAYOUT_T>
+class test_gutter_retrieve_parallel {
+private:
+	typedef std::size_t INDEX_T;
+
+	const add<long> functor;
+	gutter_thread_pool& pool;
+	const INDEX_T grain;
+	std::vector<long> values;
+	gutter_retrieve<long,add<long>,LAYOUT_T> rsh;
+	const INDEX_T size;
+
+	static std::vector<long> random_values(INDEX_T n) {
+		std::vector<long> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = (rand()%200000)-100000;
+		return res;
+	}
+public:
+	test_gutter_retrieve_parallel(INDEX_T length, gutter_thread_pool& threads, INDEX_T g)
+	: functor(), pool(threads), grain(g), values(random_values(length)),
+	rsh(values.begin(), values.end(), pool, functor, std::allocator<long>(), grain),
+	size(length) {}
+
+	void test_assign_range(INDEX_T index1, INDEX_T index2) {
+		const std::vector<long> input = random_values(index2-index1);
+		rsh.assign(index1, index2, input.begin(), pool, grain);
+		std::copy(input.begin(), input.end(), values.begin()+index1);
+	}
+	void test_rebuild() {
+		values = random_values(size);
+		rsh.rebuild(values.begin(), values.end(), pool, grain);
+	}
+	bool test_all() {
+		for (INDEX_T i=0;i<size;++i) {
+			long tmp = 0;
+			for (INDEX_T j=i;j<=size;++j) {
+				if (rsh.accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << rsh.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+				if (j < size)
+					tmp += values[j];
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			if (round%4 == 3) {
+				test_rebuild();
+			} else {
+				const INDEX_T index1 = rand()%size;
+				test_assign_range(index1, index1 + rand()%(size-index1+1));
+			}
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+template <typename LAYOUT_T>
+bool test_parallel(gutter_thread_pool& pool, const char* name) {
+	std::cout << "Test suite:\tgutter_retrieve<T,+," << name << "> class" << std::endl;
+	std::cout << "\ttarget:\tconstructor(I,I,P), rebuild(I,I,P), assign(I,I,I,P) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 7, 64, 100, 333};
+	const std::size_t grains[] = {1, 3, 16};
+	for (unsigned s=0; s<6; ++s) {
+		for (unsigned g=0; g<3; ++g) {
+			if (!test_gutter_retrieve_parallel<LAYOUT_T>(sizes[s], pool, grains[g]).stress_test(8))
+				return false;
+		}
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	gutter_thread_pool pool(4);
+	bool passed = test_parallel<gutter_layout_bfs>(pool, "bfs");
+	passed = test_parallel<gutter_layout_blocked<3> >(pool, "blocked") && passed;
+	return passed ? 0 : 1;
+}
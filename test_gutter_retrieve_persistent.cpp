@@ -0,0 +1,121 @@
+#include "gutter_retrieve_persistent.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Checks gutter_retrieve_persistent against a copy of the array as of every
+// version
+class test_gutter_retrieve_persistent {
+private:
+	typedef std::size_t INDEX_T;
+
+	std::vector<std::vector<long> > versions;
+	gutter_retrieve_persistent<long,add<long> > psh;
+	const INDEX_T size;
+
+	static std::vector<long> random_values(INDEX_T n) {
+		std::vector<long> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = (rand()%200000)-100000;
+		return res;
+	}
+public:
+	test_gutter_retrieve_persistent(INDEX_T length)
+	: versions(1, random_values(length)), psh(versions[0].begin(), versions[0].end()),
+	size(length) {}
+
+	bool test_assign(INDEX_T index, long x) {
+		versions.push_back(versions.back());
+		versions.back()[index] = x;
+		return psh.assign(index, x) == versions.size()-1;
+	}
+	bool test_apply(INDEX_T index, long x) {
+		versions.push_back(versions.back());
+		versions.back()[index] += x;
+		return psh.apply(index, x) == versions.size()-1;
+	}
+	// Checks every element and range as of version 'v'
+	bool test_version(INDEX_T v) {
+		const std::vector<long>& values = versions[v];
+		long total = 0;
+		for (INDEX_T i=0;i<size;++i) {
+			if (psh.get(v,i) != values[i]) {
+				std::cout << "FAILURE - version " << v << ", [" << i << ']' << std::endl;
+				std::cout << "alg: \t" << psh.get(v,i) << std::endl;
+				std::cout << "true:\t" << values[i] << std::endl;
+				return false;
+			}
+			total += values[i];
+			long tmp = 0;
+			for (INDEX_T j=i;j<=size;++j) {
+				if (psh.accumulate(v,i,j) != tmp) {
+					std::cout << "FAILURE - version " << v << ", [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << psh.accumulate(v,i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+				if (j < size)
+					tmp += values[j];
+			}
+		}
+		if (psh.total(v) != total) {
+			std::cout << "FAILURE - version " << v << ", total()" << std::endl;
+			return false;
+		}
+		return true;
+	}
+	// Releases the versions older than 'oldest', and checks that they now
+	// hold only the identity element
+	bool test_collect(INDEX_T oldest) {
+		const INDEX_T first = psh.oldest_version();
+		psh.collect(oldest);
+		if (psh.oldest_version() != oldest || psh.version() != versions.size()-1) {
+			std::cout << "FAILURE - collect(" << oldest << ')' << std::endl;
+			return false;
+		}
+		for (INDEX_T v=first; v<oldest; ++v) {
+			if (psh.accumulate(v,0,size) != 0 || psh.total(v) != 0) {
+				std::cout << "FAILURE - version " << v << " still held after collect("
+						<< oldest << ')' << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_version(0))
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T index = rand()%size;
+			const long x = (rand()%200000)-100000;
+			if (!((rand()%2) ? test_assign(index, x) : test_apply(index, x))) {
+				std::cout << "FAILURE - version number of round " << round << std::endl;
+				return false;
+			}
+			const INDEX_T oldest = psh.oldest_version(), latest = psh.version();
+			if (round%16 == 15 && !test_collect(oldest + rand()%(latest-oldest+1)))
+				return false;
+			if (!test_version(latest)
+					|| !test_version(psh.oldest_version()
+						+ rand()%(latest-psh.oldest_version()+1)))
+				return false;
+		}
+		return true;
+	}
+};
+
+int main() {
+	std::cout << "Test suite:\tgutter_retrieve_persistent<T,+> class" << std::endl;
+	std::cout << "\ttarget:\tassign(I,T), apply(I,T), get(V,I), accumulate(V,I,I), total(V), collect(V) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 7, 64, 100};
+	for (unsigned s=0; s<5; ++s) {
+		if (!test_gutter_retrieve_persistent(sizes[s]).stress_test(80))
+			return 1;
+	}
+	std::cout << "Test passed." << std::endl;
+	return 0;
+}
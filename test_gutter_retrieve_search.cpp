@@ -0,0 +1,127 @@
+#include "gutter_retrieve.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+struct at_least {
+	long threshold;
+	bool operator()(long x) const {
+		return !(x < threshold);
+	}
+};
+
+// Checks find_first and lower_bound_prefix against a scan of an array of
+// non-negative elements (with many zeros), so that the predicates are monotone
+template <typename FUNCTOR_T, typename LAYOUT_T>
+class test_gutter_retrieve_search {
+private:
+	typedef std::size_t INDEX_T;
+
+	const FUNCTOR_T functor;
+	std::vector<long> values;
+	gutter_retrieve<long,FUNCTOR_T,LAYOUT_T> rsh;
+	const INDEX_T size;
+
+	static std::vector<long> random_values(INDEX_T n) {
+		std::vector<long> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = (rand()%3) ? rand()%100 : 0;
+		return res;
+	}
+public:
+	test_gutter_retrieve_search(INDEX_T length)
+	: functor(), values(random_values(length)), rsh(values.begin(), values.end()),
+	size(length) {}
+
+	void test_assign(INDEX_T index, long x) {
+		rsh.assign(index, x);
+		values[index] = x;
+	}
+	bool test_find_first(INDEX_T index1, long threshold) {
+		const at_least pred = {threshold};
+		INDEX_T tmp2 = size;
+		long res = functor();
+		for (INDEX_T i=index1; i<size; ++i) {
+			res = functor(res, values[i]);
+			if (pred(res)) {
+				tmp2 = i;
+				break;
+			}
+		}
+		const INDEX_T tmp1 = rsh.find_first(index1, pred);
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE - find_first(" << index1 << ", >=" << threshold << ')' << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return true;
+	}
+	bool test_lower_bound_prefix(long target) {
+		INDEX_T tmp2 = size;
+		long res = functor();
+		for (INDEX_T i=0; i<size; ++i) {
+			res = functor(res, values[i]);
+			if (!(res < target)) {
+				tmp2 = i;
+				break;
+			}
+		}
+		const INDEX_T tmp1 = rsh.lower_bound_prefix(target);
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE - lower_bound_prefix(" << target << ')' << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return true;
+	}
+	// Checks every starting element against thresholds up to just past the
+	// total (i.e., never reached)
+	bool test_all() {
+		const long total = rsh.total();
+		for (long t=0; t<=total+1; t+=1+rand()%(1+total/32)) {
+			if (!test_lower_bound_prefix(t))
+				return false;
+			for (INDEX_T i=0;i<=size;++i) {
+				if (!test_find_first(i, t))
+					return false;
+			}
+		}
+		return test_lower_bound_prefix(total) && test_lower_bound_prefix(total+1);
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			test_assign(rand()%size, (rand()%3) ? rand()%100 : 0);
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+template <typename FUNCTOR_T, typename LAYOUT_T>
+bool test_search(const char* name) {
+	std::cout << "Test suite:\tgutter_retrieve<T," << name << "> class" << std::endl;
+	std::cout << "\ttarget:\tfind_first(I,P), lower_bound_prefix(T) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 3, 7, 64, 100, 333};
+	for (unsigned s=0; s<7; ++s) {
+		if (!test_gutter_retrieve_search<FUNCTOR_T,LAYOUT_T>(sizes[s]).stress_test(20))
+			return false;
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	bool passed = test_search<add<long>,gutter_layout_bfs>("+,bfs");
+	passed = test_search<add<long>,gutter_layout_blocked<3> >("+,blocked") && passed;
+	passed = test_search<max<long>,gutter_layout_bfs>("max,bfs") && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+#include "gutter_parallel.h"
+#include "gutter_retrieve_sharded.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Checks gutter_retrieve_sharded against an array, over shard counts that
+// leave the last shard narrower than the rest, that are 0, and that exceed the
+// number of elements; then runs updates and queries from several threads at
+// once, checking the tree once they have finished
+class test_gutter_retrieve_sharded {
+private:
+	typedef std::size_t INDEX_T;
+
+	gutter_thread_pool& pool;
+	std::vector<long> values;
+	gutter_retrieve_sharded<long,add<long> > rsh;
+	const INDEX_T size;
+
+	static std::vector<long> random_values(INDEX_T n) {
+		std::vector<long> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = (rand()%200000)-100000;
+		return res;
+	}
+public:
+	test_gutter_retrieve_sharded(INDEX_T length, INDEX_T shard_no, gutter_thread_pool& threads)
+	: pool(threads), values(random_values(length)), rsh(length, shard_no, pool), size(length) {
+		rsh.rebuild(values.begin(), values.end());
+	}
+
+	void test_assign(INDEX_T index, long x) {
+		rsh.assign(index, x);
+		values[index] = x;
+	}
+	void test_apply(INDEX_T index, long x) {
+		rsh.apply(index, x);
+		values[index] += x;
+	}
+	void test_assign_range(INDEX_T index1, INDEX_T index2) {
+		const std::vector<long> input = random_values(index2-index1);
+		rsh.assign(index1, index2, input.begin());
+		std::copy(input.begin(), input.end(), values.begin()+index1);
+	}
+	void test_rebuild() {
+		values = random_values(size);
+		rsh.rebuild(values.begin(), values.end());
+	}
+	bool test_all() {
+		std::vector<std::pair<INDEX_T,INDEX_T> > ranges;
+		std::vector<long> expected;
+		for (INDEX_T i=0;i<size;++i) {
+			if (rsh[i] != values[i]) {
+				std::cout << "FAILURE - [" << i << ']' << std::endl;
+				std::cout << "alg: \t" << rsh[i] << std::endl;
+				std::cout << "true:\t" << values[i] << std::endl;
+				return false;
+			}
+			long tmp = 0;
+			for (INDEX_T j=i;j<=size;++j) {
+				if (rsh.accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << rsh.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+				ranges.push_back(std::make_pair(i, j));
+				expected.push_back(tmp);
+				if (j < size)
+					tmp += values[j];
+			}
+		}
+		std::vector<long> out(ranges.size());
+		rsh.accumulate_batch(ranges.data(), ranges.size(), out.data());
+		for (std::size_t q=0; q<ranges.size(); ++q) {
+			if (out[q] != expected[q]) {
+				std::cout << "FAILURE - batch [" << ranges[q].first << ", " << ranges[q].second << ')' << std::endl;
+				std::cout << "alg: \t" << out[q] << std::endl;
+				std::cout << "true:\t" << expected[q] << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all())
+			return false;
+		const INDEX_T width = rsh.shard_width();
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T index = rand()%size;
+			// A boundary between two shards, if there is one
+			const INDEX_T edge = width * (1 + rand()%((size-1)/width + 1));
+			switch (round%6) {
+			case 0:
+				test_assign(index, (rand()%200000)-100000);
+				break;
+			case 1:
+				test_apply(index, (rand()%200000)-100000);
+				break;
+			case 2:
+				test_assign_range(index, index + rand()%(size-index+1));
+				break;
+			case 3:
+				if (edge < size)
+					test_assign_range(edge-1, std::min(size, edge+1));
+				break;
+			case 4:
+				test_assign_range(edge-width, std::min(size, edge));
+				break;
+			default:
+				test_rebuild();
+			}
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+// Each writer sets the elements of every other shard, and one writer also sets
+// ranges across all of them, while readers query ranges and batches
+bool test_concurrent(gutter_thread_pool& pool) {
+	typedef std::size_t INDEX_T;
+	const INDEX_T size = 1000, shard_no = 8;
+	gutter_retrieve_sharded<long,add<long> > rsh(size, shard_no, pool);
+	const INDEX_T width = rsh.shard_width();
+	std::vector<long> values(size, 0);
+	std::vector<long> ranged(size, 1);
+	std::vector<std::thread> threads;
+	for (unsigned w=0; w<2; ++w) {
+		threads.emplace_back([&, w]() {
+			std::minstd_rand random(w+1);
+			for (unsigned k=0; k<20000; ++k) {
+				const INDEX_T index = random()%size;
+				if ((index/width)%2 != w)
+					continue;
+				long x = long(random()%100);
+				rsh.assign(index, x);
+				values[index] = x;
+			}
+		});
+	}
+	threads.emplace_back([&]() {
+		for (unsigned k=0; k<50; ++k)
+			rsh.assign(0, size, ranged.begin());
+	});
+	std::atomic<bool> passed(true);
+	for (unsigned r=0; r<2; ++r) {
+		threads.emplace_back([&, r]() {
+			std::minstd_rand random(r+3);
+			std::vector<std::pair<INDEX_T,INDEX_T> > ranges(300);
+			std::vector<long> out(ranges.size());
+			for (unsigned k=0; k<200; ++k) {
+				for (std::size_t q=0; q<ranges.size(); ++q) {
+					const INDEX_T i1 = random()%size;
+					ranges[q] = std::make_pair(i1, i1 + random()%(size-i1+1));
+				}
+				rsh.accumulate_batch(ranges.data(), ranges.size(), out.data());
+				for (std::size_t q=0; q<ranges.size(); ++q) {
+					// Every element is in [0,100) throughout
+					const long most = 99 * long(ranges[q].second - ranges[q].first);
+					if (out[q] < 0 || out[q] > most
+							|| rsh.accumulate(ranges[q].first, ranges[q].second) > most)
+						passed = false;
+				}
+			}
+		});
+	}
+	for (std::size_t t=0; t<threads.size(); ++t)
+		threads[t].join();
+	if (!passed) {
+		std::cout << "FAILURE - a concurrent query was out of bounds" << std::endl;
+		return false;
+	}
+	// The range assigns may have landed after some of the writes
+	for (INDEX_T i=0; i<size; ++i) {
+		if (rsh[i] != values[i] && rsh[i] != 1) {
+			std::cout << "FAILURE - [" << i << ']' << std::endl;
+			std::cout << "alg: \t" << rsh[i] << std::endl;
+			std::cout << "true:\t" << values[i] << std::endl;
+			return false;
+		}
+	}
+	long tmp = 0;
+	for (INDEX_T i=0; i<size; ++i) {
+		tmp += rsh[i];
+		if (rsh.accumulate(0, i+1) != tmp) {
+			std::cout << "FAILURE - [0, " << i+1 << ')' << std::endl;
+			std::cout << "alg: \t" << rsh.accumulate(0, i+1) << std::endl;
+			std::cout << "true:\t" << tmp << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+	std::cout << "Test suite:\tgutter_retrieve_sharded<T,+> class" << std::endl;
+	std::cout << "\ttarget:\tassign(S,T), apply(S,T), assign(I,I,I), rebuild(I,I), accumulate(S,S), accumulate_batch(P,S,P) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	gutter_thread_pool pool(4);
+	bool passed = true;
+	const std::size_t sizes[] = {1, 2, 7, 64, 100, 333};
+	for (unsigned s=0; s<6 && passed; ++s) {
+		const std::size_t n = sizes[s];
+		// 0 shards, 1 shard, a narrower last shard, one shard per element, and
+		// more shards than elements
+		const std::size_t shard_nos[] = {0, 1, 3, 7, n, n+5};
+		for (unsigned k=0; k<6 && passed; ++k)
+			passed = test_gutter_retrieve_sharded(n, shard_nos[k], pool).stress_test(24);
+	}
+	passed = passed && test_concurrent(pool);
+	if (passed)
+		std::cout << "Test passed." << std::endl;
+	return passed ? 0 : 1;
+}
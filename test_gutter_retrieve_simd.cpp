@@ -0,0 +1,95 @@
+#include "gutter_retrieve.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Checks the row rebuilds of construction and range assignment, vectorized for
+// add/min/max over arithmetic types (see gutter_simd.h), against an array
+template <typename RESULT_T, typename FUNCTOR_T>
+class test_gutter_retrieve_simd {
+private:
+	typedef std::size_t INDEX_T;
+
+	const FUNCTOR_T functor;
+	std::vector<RESULT_T> values;
+	gutter_retrieve<RESULT_T,FUNCTOR_T> rsh;
+	const INDEX_T size;
+
+	static RESULT_T random_value() {
+		return RESULT_T((rand()%2001)-1000);
+	}
+public:
+	test_gutter_retrieve_simd(const std::vector<RESULT_T>& source)
+	: functor(), values(source), rsh(source.begin(), source.end()), size(source.size()) {}
+
+	void test_assign_range(INDEX_T index1, INDEX_T index2) {
+		std::vector<RESULT_T> input(index2-index1);
+		for (INDEX_T i=0; i<input.size(); ++i)
+			input[i] = random_value();
+		rsh.assign(index1, index2, input.begin());
+		std::copy(input.begin(), input.end(), values.begin()+index1);
+	}
+	bool test_range(INDEX_T index1, INDEX_T index2) {
+		const RESULT_T tmp1 = rsh.accumulate(index1,index2);
+		RESULT_T tmp2 = functor();
+		for (INDEX_T i=index1;i<index2;++i)
+			tmp2 = functor(tmp2, values[i]);
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE - [" << index1 << ", " << index2 << ')' << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return true;
+	}
+	bool test_all() {
+		for (INDEX_T i=0;i<=size;++i) {
+			for (INDEX_T j=i;j<=size;++j) {
+				if (!test_range(i,j))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T index1 = rand()%size;
+			test_assign_range(index1, index1 + rand()%(size-index1+1));
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+
+	static bool run(const char* name) {
+		std::cout << "Test suite:\tgutter_retrieve<T," << name << "> class" << std::endl;
+		std::cout << "\ttarget:\tconstructor(I,I), assign(I,I,I) methods, vectorized rows" << std::endl;
+		std::cout << "\ttype:\tstress test" << std::endl;
+
+		std::cout << "Beginning Test." << std::endl;
+		for (INDEX_T n=1; n<=70; n+=3) {
+			std::vector<RESULT_T> source(n);
+			for (INDEX_T i=0; i<n; ++i)
+				source[i] = random_value();
+			if (!test_gutter_retrieve_simd(source).stress_test(10))
+				return false;
+		}
+		std::cout << "Test passed." << std::endl;
+		return true;
+	}
+};
+
+int main() {
+	bool passed = test_gutter_retrieve_simd<std::int32_t,add<std::int32_t> >::run("+ (int32)");
+	passed = test_gutter_retrieve_simd<std::int32_t,min<std::int32_t> >::run("min (int32)") && passed;
+	passed = test_gutter_retrieve_simd<std::int64_t,max<std::int64_t> >::run("max (int64)") && passed;
+	passed = test_gutter_retrieve_simd<float,min<float> >::run("min (float)") && passed;
+	passed = test_gutter_retrieve_simd<double,add<double> >::run("+ (double)") && passed;
+	passed = test_gutter_retrieve_simd<double,max<double> >::run("max (double)") && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include "gutter_retrieve_sparse.h"
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+
+// Checks gutter_retrieve_sparse against a map of its populated elements
+class test_gutter_retrieve_sparse {
+private:
+	typedef std::size_t INDEX_T;
+
+	gutter_retrieve_sparse<long,add<long> > ssh;
+	std::map<INDEX_T,long> values;
+	const INDEX_T size;
+
+	INDEX_T random_index() const {
+		// Clusters half of the indices, so that leaves share long paths
+		const INDEX_T r = (INDEX_T(rand()) << 31) ^ INDEX_T(rand());
+		return (rand()%2) ? r%size : (size/3 + r%16)%size;
+	}
+	long expected(INDEX_T index1, INDEX_T index2) const {
+		long res = 0;
+		for (std::map<INDEX_T,long>::const_iterator it=values.lower_bound(index1);
+				it!=values.end() && it->first<index2; ++it)
+			res += it->second;
+		return res;
+	}
+public:
+	test_gutter_retrieve_sparse(INDEX_T length)
+	: ssh(length), size(length) {}
+
+	void test_assign(INDEX_T index, long x) {
+		ssh.assign(index, x);
+		values[index] = x;
+	}
+	void test_apply(INDEX_T index, long x) {
+		ssh.apply(index, x);
+		values[index] += x;
+	}
+	bool test_range(INDEX_T index1, INDEX_T index2) {
+		const long tmp1 = ssh.accumulate(index1,index2), tmp2 = expected(index1,index2);
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE - [" << index1 << ", " << index2 << ')' << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return true;
+	}
+	bool test_element(INDEX_T index) {
+		const long tmp2 = values.count(index) ? values[index] : 0;
+		if (ssh[index] != tmp2) {
+			std::cout << "FAILURE - [" << index << ']' << std::endl;
+			std::cout << "alg: \t" << ssh[index] << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return true;
+	}
+	// Checks every populated element, and the ranges between and around any
+	// two of them (or every element and range, if the domain is small)
+	bool test_all() {
+		if (ssh.node_count() > 2*values.size()+1) {
+			std::cout << "FAILURE - " << ssh.node_count() << " nodes for "
+					<< values.size() << " elements" << std::endl;
+			return false;
+		}
+		if (size <= 64) {
+			for (INDEX_T i=0;i<size;++i) {
+				if (!test_element(i))
+					return false;
+				for (INDEX_T j=i;j<=size;++j) {
+					if (!test_range(i,j))
+						return false;
+				}
+			}
+			return true;
+		}
+		std::vector<INDEX_T> bounds(1, 0);
+		bounds.push_back(size);
+		for (std::map<INDEX_T,long>::const_iterator it=values.begin(); it!=values.end(); ++it) {
+			if (!test_element(it->first) || !test_element(random_index()))
+				return false;
+			bounds.push_back(it->first);
+			bounds.push_back(it->first+1);
+		}
+		for (std::size_t a=0; a<bounds.size(); ++a) {
+			for (std::size_t b=0; b<bounds.size(); ++b) {
+				if (bounds[a] <= bounds[b] && !test_range(bounds[a], bounds[b]))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T index = random_index();
+			if (rand()%2)
+				test_assign(index, (rand()%200000)-100000);
+			else
+				test_apply(index, (rand()%200000)-100000);
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+int main() {
+	std::cout << "Test suite:\tgutter_retrieve_sparse<T,+> class" << std::endl;
+	std::cout << "\ttarget:\tassign(I,T), apply(I,T), operator[], accumulate(I,I) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 7, 64, 1000, std::size_t(1) << 40};
+	for (unsigned s=0; s<6; ++s) {
+		if (!test_gutter_retrieve_sparse(sizes[s]).stress_test(60))
+			return 1;
+	}
+	std::cout << "Test passed." << std::endl;
+	return 0;
+}
@@ -57,13 +57,14 @@ public:
 		return tmp1==tmp2;
 	}
 
-	void stress_test() {
+	// Runs 'rounds' rounds of one apply and a check of every range around it
+	bool stress_test(INDEX_T rounds) {
 		std::cout << "Test suite:\tgutter_retrieve<T,+> class" << std::endl;
 		std::cout << "\ttarget:\tapply(T), accumulate(I,I) methods" << std::endl;
 		std::cout << "\ttype:\tstress test" << std::endl;
 
 		std::cout << "Beginning Test." << std::endl;
-		while (true) {
+		for (INDEX_T round=0; round<rounds; ++round) {
 			// Change values
 			const INDEX_T index = rand()%size;
 			test_add_to(index,(rand()%200000)+1, true);
@@ -71,15 +72,16 @@ public:
 			for (INDEX_T i=0;i<=index;++i) {
 				for (INDEX_T j=index;j<=size;++j) {
 					if (!test_sum_range(i,j)) {
-						return;
+						return false;
 					}
 				}
 			}
 		}
+		std::cout << "Test passed." << std::endl;
+		return true;
 	}
 };
 
 int main() {
-	test_gutter_retrieve_sum<int>(1000).stress_test();
-	return 0;
+	return test_gutter_retrieve_sum<int>(1000).stress_test(20) ? 0 : 1;
 }
@@ -0,0 +1,169 @@
+#include "gutter_retrieve_wide.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Composition of the maps x -> a*x+b (mod 1009), applying the left map first:
+// a non-commutative functor, so that the tree must keep its elements in order
+struct affine_map {
+	long a, b;
+	bool operator!=(const affine_map& other) const {
+		return a != other.a || b != other.b;
+	}
+};
+std::ostream& operator<<(std::ostream& os, const affine_map& f) {
+	return os << f.a << "x+" << f.b;
+}
+struct compose {
+	affine_map operator()() const {
+		affine_map res = {1, 0};
+		return res;
+	}
+	affine_map operator()(const affine_map& f1, const affine_map& f2) const {
+		affine_map res = {f1.a*f2.a % 1009, (f1.b*f2.a + f2.b) % 1009};
+		return res;
+	}
+};
+
+long random_long() {
+	return (rand()%2001)-1000;
+}
+affine_map random_map() {
+	affine_map res = {rand()%1009, rand()%1009};
+	return res;
+}
+
+// Checks gutter_retrieve_wide against a fold of an array through op(), over
+// sizes that are not a multiple of the fanout
+template <typename RESULT_T, typename FUNCTOR_T, std::size_t FANOUT>
+class test_gutter_retrieve_wide {
+private:
+	typedef std::size_t INDEX_T;
+	typedef RESULT_T (*random_t)();
+
+	const FUNCTOR_T functor;
+	const random_t random_value;
+	std::vector<RESULT_T> values;
+	gutter_retrieve_wide<RESULT_T,FUNCTOR_T,FANOUT> rsh;
+	const INDEX_T size;
+
+	static std::vector<RESULT_T> random_values(INDEX_T n, random_t random) {
+		std::vector<RESULT_T> res(n);
+		for (INDEX_T i=0; i<n; ++i)
+			res[i] = random();
+		return res;
+	}
+public:
+	test_gutter_retrieve_wide(INDEX_T length, random_t random)
+	: functor(), random_value(random), values(random_values(length, random)),
+	rsh(values.begin(), values.end()), size(length) {}
+
+	void test_assign(INDEX_T index) {
+		RESULT_T x = random_value();
+		rsh.assign(index, x);
+		values[index] = x;
+	}
+	void test_apply(INDEX_T index) {
+		RESULT_T x = random_value();
+		rsh.apply(index, x);
+		values[index] = functor(values[index], x);
+	}
+	void test_assign_range(INDEX_T index1, INDEX_T index2) {
+		const std::vector<RESULT_T> input = random_values(index2-index1, random_value);
+		rsh.assign(index1, index2, input.begin());
+		std::copy(input.begin(), input.end(), values.begin()+index1);
+	}
+	void test_rebuild() {
+		values = random_values(size, random_value);
+		rsh.rebuild(values.begin(), values.end());
+	}
+	// The clone must keep its values through an assign to the tree
+	bool test_clone() {
+		gutter_retrieve_wide<RESULT_T,FUNCTOR_T,FANOUT> copy = rsh.clone();
+		std::vector<RESULT_T> kept = values;
+		test_assign(rand()%size);
+		rsh.swap(copy);
+		values.swap(kept);
+		if (!test_all())
+			return false;
+		rsh.swap(copy);
+		values.swap(kept);
+		return test_all();
+	}
+	bool test_all() {
+		for (INDEX_T i=0;i<=size;++i) {
+			if (i < size && rsh[i] != values[i]) {
+				std::cout << "FAILURE - [" << i << ']' << std::endl;
+				std::cout << "alg: \t" << rsh[i] << std::endl;
+				std::cout << "true:\t" << values[i] << std::endl;
+				return false;
+			}
+			RESULT_T tmp = functor();
+			for (INDEX_T j=i;j<=size;++j) {
+				if (rsh.accumulate(i,j) != tmp) {
+					std::cout << "FAILURE - [" << i << ", " << j << ')' << std::endl;
+					std::cout << "alg: \t" << rsh.accumulate(i,j) << std::endl;
+					std::cout << "true:\t" << tmp << std::endl;
+					return false;
+				}
+				if (j < size)
+					tmp = functor(tmp, values[j]);
+			}
+		}
+		return true;
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all() || !test_clone())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T index = rand()%size;
+			switch (round%4) {
+			case 0:
+				test_assign(index);
+				break;
+			case 1:
+				test_apply(index);
+				break;
+			case 2:
+				test_assign_range(index, index + rand()%(size-index+1));
+				break;
+			default:
+				test_rebuild();
+			}
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+template <typename RESULT_T, typename FUNCTOR_T, std::size_t FANOUT>
+bool test_wide(RESULT_T (*random)(), const char* name) {
+	std::cout << "Test suite:\tgutter_retrieve_wide<T," << name << ',' << FANOUT << "> class" << std::endl;
+	std::cout << "\ttarget:\tconstructor(I,I), clone(), assign(S,T), apply(S,T), assign(I,I,I), rebuild(I,I), accumulate(S,S) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, FANOUT-1, FANOUT, FANOUT+1, 3*FANOUT+2,
+			FANOUT*FANOUT+5, 300};
+	for (unsigned s=0; s<8; ++s) {
+		if (!test_gutter_retrieve_wide<RESULT_T,FUNCTOR_T,FANOUT>(sizes[s], random).stress_test(24))
+			return false;
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	// add applies to each ancestor directly; compose recomputes them
+	bool passed = test_wide<long,add<long>,2>(random_long, "+");
+	passed = test_wide<long,add<long>,4>(random_long, "+") && passed;
+	passed = test_wide<long,add<long>,16>(random_long, "+") && passed;
+	passed = test_wide<long,min<long>,16>(random_long, "min") && passed;
+	passed = test_wide<affine_map,compose,2>(random_map, "compose") && passed;
+	passed = test_wide<affine_map,compose,4>(random_map, "compose") && passed;
+	passed = test_wide<affine_map,compose,16>(random_map, "compose") && passed;
+	return passed ? 0 : 1;
+}
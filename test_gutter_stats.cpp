@@ -0,0 +1,187 @@
+#include "gutter_apply.h"
+#include "gutter_retrieve.h"
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <vector>
+
+// Keeps the leftmost element: a non-commutative functor, for the ordered walk
+struct leftmost {
+	long operator()() const {
+		return LONG_MIN;
+	}
+	long operator()(long x1, long x2) const {
+		return (x1 != LONG_MIN) ? x1 : x2;
+	}
+};
+
+// The members of gutter_base, without an instrumentation policy
+struct uninstrumented {
+	std::size_t size;
+	gutter_layout_bfs layout;
+	std::allocator<long> alloc;
+	bool owns_heap;
+	long* heap;
+	add<long> op;
+};
+static_assert(sizeof(gutter_retrieve<long,add<long> >) == sizeof(uninstrumented),
+		"gutter_stats_none must add nothing to a tree");
+static_assert(sizeof(gutter_apply<long,add<long> >::stats_type) == 1,
+		"gutter_stats_none must be empty");
+
+// Checks the counts of gutter_stats_counting against those expected from the
+// shape of the tree, one operation at a time
+class test_gutter_stats {
+private:
+	typedef std::size_t INDEX_T;
+	typedef gutter_retrieve<long,add<long>,gutter_layout_bfs,std::allocator<long>,
+			gutter_stats_counting> retrieve_t;
+	typedef gutter_retrieve<long,leftmost,gutter_layout_bfs,std::allocator<long>,
+			gutter_stats_counting> ordered_t;
+	typedef gutter_apply<long,add<long>,gutter_layout_bfs,std::allocator<long>,
+			gutter_stats_counting> apply_t;
+
+	std::vector<long> values;
+	retrieve_t rsh;
+	ordered_t osh;
+	apply_t ash;
+	const INDEX_T size;
+
+	// = the number of (strict) ancestors of a node
+	static INDEX_T depth(INDEX_T index) {
+		INDEX_T d = 0;
+		for (; index > 1; index /= 2)
+			++d;
+		return d;
+	}
+	// = the number of distinct (strict) ancestors of the leaves [i1,i2)
+	INDEX_T ancestor_count(INDEX_T i1, INDEX_T i2) const {
+		std::set<INDEX_T> ancestors;
+		for (INDEX_T i=i1; i<i2; ++i) {
+			for (INDEX_T index=gutter_index::index_nth_leaf(i, size)/2; index>0; index/=2)
+				ancestors.insert(index);
+		}
+		return ancestors.size();
+	}
+	static bool check(const gutter_stats& s, const char* name, unsigned long walks,
+			unsigned long invocations, unsigned long nodes, unsigned long levels) {
+		if (s.walks != walks || s.invocations != invocations
+				|| s.nodes != nodes || s.levels != levels) {
+			std::cout << "FAILURE - " << name << std::endl;
+			std::cout << "alg: \twalks " << s.walks << ", invocations " << s.invocations
+					<< ", nodes " << s.nodes << ", levels " << s.levels << std::endl;
+			std::cout << "true:\twalks " << walks << ", invocations " << invocations
+					<< ", nodes " << nodes << ", levels " << levels << std::endl;
+			return false;
+		}
+		return true;
+	}
+public:
+	test_gutter_stats(INDEX_T length)
+	: values(length, 1), rsh(values.begin(), values.end()),
+	osh(values.begin(), values.end()), ash(length), size(length) {}
+
+	bool test_accumulate(INDEX_T i1, INDEX_T i2) {
+		// Branch-free walk: two nodes per row, one functor call per row
+		rsh.reset_stats();
+		rsh.accumulate(i1, i2);
+		const gutter_stats s = rsh.stats();
+		if (!check(s, "accumulate (commutative)", 1, s.levels, 2*s.levels, s.levels)
+				|| s.levels > 2*(depth(2*size-1)+1))
+			return false;
+		// Ordered walk: the minimal covering ancestors, one at a time
+		INDEX_T path[gutter_index::max_covering];
+		const INDEX_T covering = gutter_index::index_min_covering_ancestors(i1, i2, size, path);
+		osh.reset_stats();
+		osh.accumulate(i1, i2);
+		return check(osh.stats(), "accumulate (ordered)", 1, covering, covering,
+				osh.stats().levels);
+	}
+	bool test_point(INDEX_T index) {
+		const INDEX_T d = depth(gutter_index::index_nth_leaf(index, size));
+		long x = rand()%100;
+		rsh.reset_stats();
+		rsh.apply(index, x);
+		if (!check(rsh.stats(), "apply(I,T)", 1, d, d, d))
+			return false;
+		rsh.reset_stats();
+		rsh.assign(index, x);
+		if (!check(rsh.stats(), "assign(I,T)", 1, d, d, d))
+			return false;
+		// Consolidates the ancestors of the leaf, root first
+		ash.reset_stats();
+		ash.assign(index, x);
+		return check(ash.stats(), "gutter_apply::assign(I,T)", 1, d, d, d);
+	}
+	bool test_assign_range(INDEX_T i1, INDEX_T i2) {
+		const std::vector<long> input(i2-i1, 1);
+		rsh.reset_stats();
+		rsh.assign(i1, i2, input.begin());
+		const gutter_stats s = rsh.stats();
+		// Each leaf, then each run of ancestors in a row
+		return check(s, "assign(I,I,I)", 1, s.invocations,
+				(i2-i1) + ancestor_count(i1, i2), s.levels)
+			&& s.invocations >= i2-i1;
+	}
+	bool test_copy(INDEX_T i1, INDEX_T i2) {
+		long x = 1;
+		ash.apply(0, size, x);
+		std::vector<long> output(i2-i1);
+		ash.reset_stats();
+		ash.copy(i1, i2, output.begin());
+		const gutter_stats s = ash.stats();
+		// Consolidates each ancestor of the range, then reads each leaf
+		return check(s, "gutter_apply::copy(I,I,I)", 1, s.invocations,
+				ancestor_count(i1, i2) + (i2-i1), s.levels);
+	}
+
+	bool stress_test(unsigned rounds) {
+		for (unsigned round=0; round<rounds; ++round) {
+			const INDEX_T i1 = rand()%size;
+			const INDEX_T i2 = i1 + 1 + rand()%(size-i1);
+			if (!test_accumulate(i1, i2) || !test_point(i1)
+					|| !test_assign_range(i1, i2) || !test_copy(i1, i2))
+				return false;
+		}
+		// A range wrapping from the deepest row around to the row above it
+		return size < 3 || test_accumulate(1, size-1);
+	}
+};
+
+// The default policy counts nothing
+bool test_zero(const gutter_stats& s) {
+	if (s.walks || s.invocations || s.nodes || s.levels) {
+		std::cout << "FAILURE - gutter_stats_none counted " << s.walks << " walks" << std::endl;
+		return false;
+	}
+	return true;
+}
+bool test_none() {
+	std::vector<long> values(100, 1);
+	gutter_retrieve<long,add<long> > rsh(values.begin(), values.end());
+	gutter_apply<long,add<long> > ash(100);
+	long x = 1;
+	rsh.accumulate(3, 97);
+	rsh.assign(0, 100, values.begin());
+	ash.apply(0, 100, x);
+	ash.copy(0, 100, values.begin());
+	return test_zero(rsh.stats()) && test_zero(ash.stats());
+}
+
+int main() {
+	std::cout << "Test suite:\tgutter_retrieve/gutter_apply<T,+,bfs,A,gutter_stats_counting> classes" << std::endl;
+	std::cout << "\ttarget:\tstats() of accumulate(I,I), apply(I,T), assign(I,T), assign(I,I,I), copy(I,I,I) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t sizes[] = {1, 2, 3, 7, 64, 100, 1000};
+	for (unsigned s=0; s<7; ++s) {
+		if (!test_gutter_stats(sizes[s]).stress_test(50))
+			return 1;
+	}
+	if (!test_none())
+		return 1;
+	std::cout << "Test passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,129 @@
+#include "gutter_window.h"
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Keeps the leftmost (i.e., oldest) element: a non-commutative functor, so that
+// the order of the window is checked
+struct leftmost {
+	long operator()() const {
+		return LONG_MIN;
+	}
+	long operator()(long x1, long x2) const {
+		return (x1 != LONG_MIN) ? x1 : x2;
+	}
+};
+
+// Checks a window type against a fold over the last 'W' elements of an array
+// of everything pushed
+template <typename WINDOW_T, typename FUNCTOR_T>
+class test_gutter_window {
+private:
+	typedef std::size_t INDEX_T;
+
+	const FUNCTOR_T functor;
+	WINDOW_T wsh;
+	std::vector<long> pushed;
+	const INDEX_T width;
+
+	long expected(INDEX_T k) const {
+		// = the operation over the 'k' newest elements
+		long res = functor();
+		for (INDEX_T i=pushed.size()-k; i<pushed.size(); ++i)
+			res = functor(res, pushed[i]);
+		return res;
+	}
+	INDEX_T window_size() const {
+		return (pushed.size() < width) ? pushed.size() : width;
+	}
+	bool test_newest(const gutter_window<long,FUNCTOR_T>& w) const {
+		for (INDEX_T k=0; k<=width+1; ++k) {
+			const long tmp1 = w.newest_result(k);
+			const long tmp2 = expected((k < window_size()) ? k : window_size());
+			if (tmp1 != tmp2) {
+				std::cout << "FAILURE - newest_result(" << k << ')' << std::endl;
+				std::cout << "alg: \t" << tmp1 << std::endl;
+				std::cout << "true:\t" << tmp2 << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+	template <typename OTHER_T>
+	bool test_newest(const OTHER_T&) const {
+		return true;
+	}
+public:
+	test_gutter_window(INDEX_T w)
+	: functor(), wsh(w), width(w) {}
+
+	void test_push(long x) {
+		wsh.push(x);
+		pushed.push_back(x);
+	}
+	void test_push_n(INDEX_T k) {
+		std::vector<long> input(k);
+		for (INDEX_T i=0; i<k; ++i)
+			input[i] = (rand()%200000)-100000;
+		wsh.push_n(input.begin(), k);
+		pushed.insert(pushed.end(), input.begin(), input.end());
+	}
+	bool test_all() {
+		if (wsh.size() != window_size() || wsh.width() != width) {
+			std::cout << "FAILURE - size " << wsh.size() << ", width " << wsh.width()
+					<< " after " << pushed.size() << " pushes" << std::endl;
+			return false;
+		}
+		const long tmp1 = wsh.window_result(), tmp2 = expected(window_size());
+		if (tmp1 != tmp2) {
+			std::cout << "FAILURE - window_result() after " << pushed.size() << " pushes" << std::endl;
+			std::cout << "alg: \t" << tmp1 << std::endl;
+			std::cout << "true:\t" << tmp2 << std::endl;
+			return false;
+		}
+		return test_newest(wsh);
+	}
+
+	bool stress_test(unsigned rounds) {
+		if (!test_all())
+			return false;
+		for (unsigned round=0; round<rounds; ++round) {
+			if (rand()%4)
+				test_push((rand()%200000)-100000);
+			else
+				test_push_n(rand()%(2*width+2));
+			if (!test_all())
+				return false;
+		}
+		return true;
+	}
+};
+
+template <typename WINDOW_T, typename FUNCTOR_T>
+bool test_window(const char* name) {
+	std::cout << "Test suite:\t" << name << " class" << std::endl;
+	std::cout << "\ttarget:\tpush(T), push_n(I,I), window_result(), newest_result(I) methods" << std::endl;
+	std::cout << "\ttype:\tstress test" << std::endl;
+
+	std::cout << "Beginning Test." << std::endl;
+	const std::size_t widths[] = {1, 2, 3, 7, 64, 100};
+	for (unsigned w=0; w<6; ++w) {
+		if (!test_gutter_window<WINDOW_T,FUNCTOR_T>(widths[w]).stress_test(300))
+			return false;
+	}
+	std::cout << "Test passed." << std::endl;
+	return true;
+}
+
+int main() {
+	bool passed = test_window<gutter_window<long,add<long> >,add<long> >(
+			"gutter_window<T,+>");
+	passed = test_window<gutter_window<long,leftmost>,leftmost>(
+			"gutter_window<T,leftmost>") && passed;
+	passed = test_window<gutter_window_stacks<long,add<long> >,add<long> >(
+			"gutter_window_stacks<T,+>") && passed;
+	passed = test_window<gutter_window_stacks<long,leftmost>,leftmost>(
+			"gutter_window_stacks<T,leftmost>") && passed;
+	return passed ? 0 : 1;
+}